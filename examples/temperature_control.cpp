@@ -1,5 +1,6 @@
 #include <dcs/control_system.h>
 #include <dcs/module.h>
+#include <dcs/pid_bank.h>
 #include <iostream>
 #include <random>
 #include <cmath>
@@ -39,7 +40,7 @@ public:
         
         readCount_++;
         
-        return dcs::SensorData("temperature", currentTemp_, dcs::Unit::CELSIUS);
+        return dcs::SensorData(signal_, currentTemp_, dcs::Unit::CELSIUS);
     }
     
     void calibrate() override {
@@ -59,6 +60,8 @@ public:
     }
     
 private:
+    // Interned once; read() runs at 100Hz and must not allocate
+    dcs::SignalId signal_{dcs::SignalRegistry::instance().intern("temperature")};
     double currentTemp_{20.0};
     double ambientTemp_{20.0};
     double heaterPower_{0.0};
@@ -80,6 +83,12 @@ public:
         setState(dcs::ModuleState::READY);
     }
     
+    void start() override {
+        // The first command is rate-limited over the time since the loops started
+        lastExecute_ = std::chrono::steady_clock::now();
+        ActuatorModule::start();
+    }
+    
     void execute(const dcs::ActuatorCommand& cmd) override {
         if (!validateCommand(cmd)) {
             throw std::runtime_error("Invalid heater command");
@@ -90,9 +99,12 @@ public:
             return;
         }
         
-        // Apply rate limiting
+        // Apply rate limiting over the real time since the last command
+        auto now = std::chrono::steady_clock::now();
+        double dt = std::chrono::duration<double>(now - lastExecute_).count();
+        lastExecute_ = now;
         double targetPower = cmd.value;
-        double maxChange = limits_.maxRate * 0.01; // Convert to per-cycle change
+        double maxChange = limits_.maxRate * dt;
         
         if (std::abs(targetPower - powerLevel_) > maxChange) {
             powerLevel_ += (targetPower > powerLevel_ ? maxChange : -maxChange);
@@ -119,49 +131,7 @@ public:
     
 private:
     std::atomic<double> powerLevel_{0.0};
-};
-
-// PID controller implementation
-class PIDController {
-public:
-    PIDController(double kp, double ki, double kd) 
-        : kp_(kp), ki_(ki), kd_(kd) {}
-    
-    double calculate(double setpoint, double measurement, double dt) {
-        double error = setpoint - measurement;
-        
-        // Proportional term
-        double p = kp_ * error;
-        
-        // Integral term with anti-windup
-        integral_ += error * dt;
-        integral_ = std::clamp(integral_, -integralLimit_, integralLimit_);
-        double i = ki_ * integral_;
-        
-        // Derivative term with filtering
-        double derivative = (error - lastError_) / dt;
-        derivative = alpha_ * derivative + (1 - alpha_) * lastDerivative_;
-        double d = kd_ * derivative;
-        
-        lastError_ = error;
-        lastDerivative_ = derivative;
-        
-        return std::clamp(p + i + d, 0.0, 100.0); // Clamp to actuator limits
-    }
-    
-    void reset() {
-        integral_ = 0.0;
-        lastError_ = 0.0;
-        lastDerivative_ = 0.0;
-    }
-    
-private:
-    double kp_, ki_, kd_;
-    double integral_{0.0};
-    double lastError_{0.0};
-    double lastDerivative_{0.0};
-    double integralLimit_{50.0};
-    double alpha_{0.1}; // Derivative filter coefficient
+    std::chrono::steady_clock::time_point lastExecute_{};
 };
 
 // Main example
@@ -183,21 +153,36 @@ int main() {
         // system.loadModule("./libtemperature_sensor.so");
         // system.loadModule("./libheater_actuator.so");
         
-        // Initialize modules
-        tempSensor->initialize();
-        heater->initialize();
+        // Register and initialize modules (in parallel, in dependency order)
+        auto startup = system.addModules({tempSensor, heater});
+        for (const auto& record : startup.modules) {
+            std::cout << "  " << record.name << " initialized in "
+                      << (record.initEnd - record.initStart).count() << " μs"
+                      << (record.success ? "" : " FAILED: " + record.error) << std::endl;
+        }
+        if (!startup.success) {
+            return 1;
+        }
         
         // Create PID controller
-        PIDController pid(2.0, 0.5, 0.1); // Tuned PID parameters
+        dcs::PidController pid(2.0, 0.5, 0.1); // Tuned PID parameters
         double setpoint = 25.0; // Target temperature: 25°C
         
         // Create control loop
         system.createControlLoop("TemperatureControl", 50); // 50Hz control loop
         
+        // Thermal dynamics are slow: under overload, run at a reduced rate
+        dcs::TimingPolicy timing;
+        timing.overrun = dcs::OverrunPolicy::DEGRADE;
+        system.setLoopTiming("TemperatureControl", timing);
+        
+        // Resolve the actuator target once, outside the control loop
+        const dcs::SignalId heaterSignal = dcs::SignalRegistry::instance().intern("heater");
+        
         // Define control logic
         auto lastTime = std::chrono::steady_clock::now();
         system.setControlFunction("TemperatureControl", 
-            [&pid, &lastTime, setpoint](const dcs::SensorData& input) {
+            [&pid, &lastTime, setpoint, heaterSignal](const dcs::SensorData& input) {
                 auto now = std::chrono::steady_clock::now();
                 double dt = std::chrono::duration<double>(now - lastTime).count();
                 lastTime = now;
@@ -207,7 +192,7 @@ int main() {
                 std::cout << "Temperature: " << input.value << "°C, "
                           << "Control: " << controlOutput << "%" << std::endl;
                 
-                return dcs::ActuatorCommand("heater", controlOutput);
+                return dcs::ActuatorCommand(heaterSignal, controlOutput);
             });
         
         // Set up metrics monitoring
@@ -234,8 +219,9 @@ int main() {
         
         system.start();
         
-        // Simulate temperature feedback loop
+        // Simulate temperature feedback loop, released on an absolute 50Hz grid
         auto startTime = std::chrono::steady_clock::now();
+        auto nextRelease = startTime;
         while (true) {
             // Read temperature
             auto sensorData = tempSensor->read();
@@ -248,7 +234,7 @@ int main() {
             double controlOutput = pid.calculate(setpoint, sensorData.value, dt);
             
             // Execute control
-            heater->execute(dcs::ActuatorCommand("heater", controlOutput));
+            heater->execute(dcs::ActuatorCommand(heaterSignal, controlOutput));
             
             // Update sensor with heater feedback (simulation only)
             tempSensor->setHeaterPower(heater->getPowerLevel());
@@ -259,8 +245,9 @@ int main() {
                 break;
             }
             
-            // Control loop delay
-            std::this_thread::sleep_for(std::chrono::milliseconds(20)); // 50Hz
+            // Sleep to the next release so the work time does not accumulate as drift
+            nextRelease += std::chrono::milliseconds(20);
+            std::this_thread::sleep_until(nextRelease);
         }
         
         // Stop the system
@@ -273,8 +260,10 @@ int main() {
         std::cout << "  Total uptime: " << finalMetrics.getUptime() << " seconds" << std::endl;
         std::cout << "  Average latency: " << finalMetrics.avgLatency << " μs" << std::endl;
         std::cout << "  Maximum latency: " << finalMetrics.maxLatency << " μs" << std::endl;
+        std::cout << "  P99.9 latency: " << finalMetrics.latency.p999 / 1000.0 << " μs" << std::endl;
         std::cout << "  Total messages: " << finalMetrics.totalMessages << std::endl;
         std::cout << "  Dropped messages: " << finalMetrics.droppedMessages << std::endl;
+        std::cout << "  Missed deadlines: " << finalMetrics.missedDeadlines << std::endl;
         
     } catch (const std::exception& e) {
         std::cerr << "Error: " << e.what() << std::endl;
@@ -1,23 +1,64 @@
 #pragma once
 
 #include "module.h"
+#include "module_table.h"
+#include "message_queue.h"
+#include "shared_memory.h"
+#include "shared_memory_pool.h"
+#include "sensor_board.h"
+#include "scheduler.h"
+#include "watchdog.h"
+#include "event_trigger.h"
+#include "dataflow.h"
+#include "flight_recorder.h"
+#include <condition_variable>
 #include <unordered_map>
+#include <optional>
 #include <thread>
 #include <mutex>
-#include <condition_variable>
-#include <queue>
 #include <dlfcn.h>
 
 namespace dcs {
 
+class ReplayWriter;
+
+// Where the housekeeping threads (metrics, watchdog) may run
+enum class IsolationPolicy {
+    NONE,                   // Anywhere, including the scheduler CPUs
+    HOUSEKEEPING_OFF_RT     // On housekeepingCpus, or every CPU outside schedulerCpus
+};
+
 // Configuration structure
 struct Config {
     size_t sharedMemorySize{100 * 1024 * 1024}; // 100MB default
     size_t messageQueueSize{10000};
+    size_t sensorBoardSlots{4096};  // Distinct signals on the latest-value board, 0 = no board
+    size_t sharedPoolSize{64 * 1024 * 1024};   // Allocator arena carved out of sharedMemorySize
+    QueueMode messageQueueMode{QueueMode::MPMC};
     bool enableRedundancy{false};
     bool enableMetrics{true};
     std::string logLevel{"INFO"};
-    std::chrono::milliseconds watchdogTimeout{5000};
+    std::chrono::milliseconds watchdogTimeout{5000};   // Upper bound on a loop's default timeout
+    std::chrono::microseconds watchdogTick{1000};      // Expiry detection granularity
+    
+    // Control loop scheduling: loops share a fixed pool of worker threads
+    size_t schedulerThreads{0};         // 0 = one per hardware thread
+    std::vector<int> schedulerCpus;     // CPUs to pin scheduler workers to, empty = unpinned
+    WaitOptions loopWait;               // How workers wait for releases; mode is the loop default
+    
+    // Real-time setup at start(). Each step is best effort: without the
+    // privilege it is reported through the error callback and skipped.
+    std::unordered_map<std::string, int> loopPriorities;   // SCHED_FIFO priority (1-99) by loop name
+    IsolationPolicy isolation{IsolationPolicy::NONE};
+    std::vector<int> housekeepingCpus;  // Empty = every CPU outside schedulerCpus
+    bool lockMemory{false};             // mlockall current and future pages
+    bool prefault{false};               // Fault in the shared memory segment and worker stacks
+    size_t prefaultStackBytes{256 * 1024};
+    
+    // Flight recorder: every loop keeps its latest samples and commands in
+    // memory, dumped to flightRecorderDir on emergencyStop() or watchdog expiry
+    size_t flightRecorderRecords{4096};     // Records kept per loop (32 bytes each), 0 = off
+    std::string flightRecorderDir{"/tmp"};
 };
 
 // Control loop definition
@@ -26,8 +67,44 @@ struct ControlLoop {
     double frequency;
     std::vector<std::string> sensorModules;
     std::vector<std::string> actuatorModules;
+    // Interned by addSensorToLoop/addActuatorToLoop so the loop never compares names
+    std::vector<SignalId> sensorSignals;
+    std::vector<SignalId> actuatorSignals;
+    // Resolved off the cycle thread and published whole: a cycle reads the
+    // current set inside its EpochGuard and looks modules up without locking
+    struct Handles {
+        std::vector<ModuleHandle<SensorModule>> sensors;
+        std::vector<ModuleHandle<ActuatorModule>> actuators;
+    };
+    std::atomic<const Handles*> handles{nullptr};
+    std::shared_ptr<const Handles> handlesOwner;   // Replaced under loopsMutex_, retired via EpochDomain
     ActuatorCallback controlFunction;
-    std::thread thread;
+    MimoControlFunction mimoControlFunction;   // Takes precedence over controlFunction
+    // Own the callables too large to erase in place; one per kind, so
+    // replacing one function never frees what the other still refers to
+    std::shared_ptr<void> controlState;
+    std::shared_ptr<void> mimoControlState;
+    
+    // Cycle buffers for mimoControlFunction, sized once at setup
+    std::vector<SensorData> snapshot;
+    std::vector<VectorSample> vectors;  // Multi-axis samples, parallel to snapshot
+    std::vector<ActuatorCommand> commands;
+    uint64_t cycleCount{0};
+    
+    LatencyHistogram latency;   // Sensor read to actuator dispatch, per cycle
+    size_t schedulerTask{SIZE_MAX};     // Index of this loop in ControlSystem's LoopScheduler, SIZE_MAX if none
+    TimingPolicy timing;                // Deadline and overrun policy, handed to the scheduler at start()
+    std::optional<WaitMode> waitMode;   // Overrides Config::loopWait.mode
+    FlightRecorder::Channel* recorder{nullptr};     // Set up with the cycle buffers unless disabled
+    std::shared_ptr<ReplayWriter> capture;          // Set = every cycle is appended; std::atomic_load/exchange only
+    std::shared_ptr<const VirtualClock> clock;      // Set = cycle timestamps come from here, not TscClock
+    std::optional<TriggerPolicy> trigger;   // Set = event-driven: cycles on fresh samples, not per period
+    std::thread eventThread;            // Runs runEventLoop() for event-driven loops
+    std::shared_ptr<DataflowSchedule> dataflow;     // Set = this loop runs one branch of a compiled graph
+    size_t dataflowBranch{0};
+    WatchId watch{INVALID_WATCH};       // Armed with watchTimeout while the system runs
+    std::chrono::microseconds watchTimeout{0};
+    Heartbeat heartbeat;                // Beaten once per completed cycle
     std::atomic<bool> running{false};
 };
 
@@ -37,6 +114,10 @@ struct SystemMetrics {
     double memoryUsage;
     double avgLatency;
     double maxLatency;
+    LatencySummary latency;                                     // All loops merged
+    std::unordered_map<std::string, LatencySummary> loopLatency; // Keyed by loop name
+    std::unordered_map<std::string, LoopTimingStats> loopTiming; // Deadline misses, WCRT, overruns
+    uint64_t missedDeadlines;                                   // All loops
     uint64_t totalMessages;
     uint64_t droppedMessages;
     std::chrono::steady_clock::time_point startTime;
@@ -47,6 +128,25 @@ struct SystemMetrics {
     }
 };
 
+// Startup timeline entry for one module of a batch load, offsets from batch start
+struct ModuleStartupRecord {
+    std::string name;
+    std::string libraryPath;
+    std::chrono::microseconds loadStart{0};   // dlopen + createModule
+    std::chrono::microseconds loadEnd{0};
+    std::chrono::microseconds initStart{0};   // initialize()
+    std::chrono::microseconds initEnd{0};
+    size_t worker{0};
+    bool success{false};
+    std::string error;
+};
+
+struct ModuleLoadReport {
+    std::vector<ModuleStartupRecord> modules;
+    std::chrono::microseconds totalTime{0};
+    bool success{false};
+};
+
 // Main control system class
 class ControlSystem {
 public:
@@ -56,14 +156,81 @@ public:
     // Module management
     bool loadModule(const std::string& libraryPath);
     bool unloadModule(const std::string& moduleName);
+    
+    // Batch startup: dlopen all libraries and run initialize() in parallel on
+    // up to `threads` workers (0 = hardware concurrency), each module starting
+    // once the modules named by its getDependencies() are initialized
+    ModuleLoadReport loadModules(const std::vector<std::string>& libraryPaths, size_t threads = 0);
+    
+    // Same for modules constructed in-process (statically linked)
+    ModuleLoadReport addModules(const std::vector<std::shared_ptr<Module>>& modules, size_t threads = 0);
+    
+    // Lazy loading: register a module under the name it exports without
+    // loading it. It is dlopened (or constructed) and initialized, together
+    // with any deferred modules it depends on, the first time its name is
+    // resolved: getModule(), resolveModule(), loop wiring at
+    // setControlFunction() or start(), a dataflow graph. Throws
+    // ControlSystemException if the name is already loaded or deferred.
+    void deferModule(const std::string& name, const std::string& libraryPath);
+    void deferModule(const std::string& name, std::function<std::shared_ptr<Module>()> factory);
+    
+    // Load deferred modules ahead of first use, all of them if names is empty
+    ModuleLoadReport loadDeferredModules(const std::vector<std::string>& names = {}, size_t threads = 0);
+    
+    // Zero-downtime hot swap: the replacement is loaded and initialized off to
+    // the side, then published between loop cycles with one pointer store.
+    // Loops never block on the swap; the old module is shut down, destroyed
+    // and its library dlclose()d only after every cycle that could still be
+    // using it has finished. On failure the old module keeps running. Loop
+    // handles follow the swap, so the replacement must be the same kind of
+    // module (sensor/actuator); re-resolve handles typed on a concrete class.
+    // Returns once the old module is torn down, so it must not be called
+    // inside an EpochGuard (std::logic_error); unloadModule() likewise.
+    bool replaceModule(const std::string& name, const std::string& newLibraryPath);
+    bool replaceModule(const std::string& name, std::shared_ptr<Module> replacement);
     std::vector<std::string> getLoadedModules() const;
     
     // Control loop management
     void createControlLoop(const std::string& name, double frequency);
+    // Busy-polling or spinning loops trade their worker's CPU for wake-up latency
+    void createControlLoop(const std::string& name, double frequency, WaitMode waitMode);
+    // A MIMO function takes precedence; setting a SISO one removes it. Throws
+    // std::logic_error while the system is running.
     void setControlFunction(const std::string& loopName, ActuatorCallback func);
+    void setControlFunction(const std::string& loopName, MimoControlFunction func);
+    
+    // Any callable with either signature. One that fits the inline buffer is
+    // stored by value in the loop; a larger one is owned by the loop and
+    // called by reference. Either way the cycle never allocates.
+    template<typename F, typename = std::enable_if_t<
+        !std::is_same<std::decay_t<F>, ActuatorCallback>::value &&
+        !std::is_same<std::decay_t<F>, MimoControlFunction>::value &&
+        (std::is_invocable_r<void, std::decay_t<F>&, const SensorSnapshot&, Span<ActuatorCommand>>::value ||
+         std::is_invocable_r<ActuatorCommand, std::decay_t<F>&, const SensorData&>::value)>>
+    void setControlFunction(const std::string& loopName, F&& func) {
+        using Fn = std::decay_t<F>;
+        using Erased = std::conditional_t<
+            std::is_invocable_r<void, Fn&, const SensorSnapshot&, Span<ActuatorCommand>>::value,
+            MimoControlFunction, ActuatorCallback>;
+        if constexpr (Erased::template fits<Fn>()) {
+            installControl(loopName, Erased(std::forward<F>(func)), nullptr);
+        } else {
+            auto owned = std::make_shared<Fn>(std::forward<F>(func));
+            Erased erased(std::ref(*owned));
+            installControl(loopName, std::move(erased), std::move(owned));
+        }
+    }
     void addSensorToLoop(const std::string& loopName, const std::string& sensorName);
     void addActuatorToLoop(const std::string& loopName, const std::string& actuatorName);
     
+    // Compile a sensor -> controller -> actuator graph and run it on the
+    // scheduler: each independent branch becomes a loop "<name>/<branch>" at
+    // the rate of its fastest node, so branches run in parallel on the worker
+    // pool. Unbound sensor and actuator nodes are bound to the loaded modules
+    // of the same name. Throws ControlSystemException if the graph is invalid
+    // or a module is missing. Returns the schedule for inspection.
+    std::shared_ptr<const DataflowSchedule> addDataflowGraph(const std::string& name, DataflowGraph graph);
+    
     // System control
     void start();
     void stop();
@@ -73,11 +240,69 @@ public:
     // Metrics and monitoring
     void enableMetrics() { metricsEnabled_ = true; }
     void setMetricsCallback(std::function<void(const SystemMetrics&)> callback);
-    SystemMetrics getMetrics() const { return metrics_; }
+    SystemMetrics getMetrics() const;
+    
+    // Latest-value board fed by every sensor read through the system
+    std::shared_ptr<SensorBoard> getSensorBoard() const { return sensorBoard_; }
+    
+    // Allocator over the shared memory segment for payloads passed between modules
+    std::shared_ptr<SharedMemoryPool> getSharedPool() const { return sharedPool_; }
+    
+    // Per-loop jitter/overrun counters; zeroes for unknown or not yet started loops
+    LoopTimingStats getLoopStats(const std::string& loopName) const {
+        std::lock_guard<std::mutex> lock(loopsMutex_);
+        auto it = controlLoops_.find(loopName);
+        if (it == controlLoops_.end() || !scheduler_ ||
+            it->second->schedulerTask >= scheduler_->taskCount()) {
+            return LoopTimingStats{};
+        }
+        return scheduler_->getStats(it->second->schedulerTask);
+    }
+    
+    // Relative deadline and overrun policy for a loop; takes effect at start()
+    void setLoopTiming(const std::string& loopName, const TimingPolicy& policy);
+    
+    // Make a loop event-driven: instead of running every period it sleeps
+    // until a quorum of its (or the listed) sensors publish fresh samples to
+    // the sensor board, and its cycles read those samples from the board.
+    // The loop frequency then only sizes the default watchdog timeout. It runs
+    // on a thread of its own; sensors no periodic loop polls are polled by the
+    // scheduler at their update rate.
+    void setLoopTrigger(const std::string& loopName, const TriggerPolicy& policy);
+    
+    // Watchdog deadlines. A loop beats once per completed cycle and defaults to
+    // ten periods (at most Config::watchdogTimeout); a module beats whenever a
+    // loop reads or drives it, or from its own threads via Module::heartbeat().
+    // Expiry is reported through the error callback within one watchdog tick.
+    // Deadlines apply only while the system runs: start() arms them and
+    // stop() disarms them.
+    void setLoopTimeout(const std::string& loopName, std::chrono::microseconds timeout);
+    void setModuleTimeout(const std::string& moduleName, std::chrono::microseconds timeout);
+    const Watchdog& getWatchdog() const { return watchdog_; }
+    
+    // Dump every loop's flight recorder ring now; path defaults to a new file
+    // in Config::flightRecorderDir. Returns the path written; throws
+    // ControlSystemException if the file cannot be written.
+    std::string dumpFlightRecorder(const std::string& reason = "on-demand", const std::string& path = "");
+    const FlightRecorder& getFlightRecorder() const { return flightRecorder_; }
+    
+    // Record/replay (see Replayer). captureLoop() streams every cycle of a
+    // loop, its snapshot and the commands produced, to path until
+    // endCapture(), which flushes the file; both may be called while the
+    // system runs and take effect between cycles. setLoopClock() makes a loop
+    // stamp its cycles from a virtual clock, and stepLoop() runs one cycle,
+    // numbered cycle, on the calling thread; neither may be called while the
+    // system is running (std::logic_error). Unknown loops and capture I/O
+    // errors throw ControlSystemException.
+    void captureLoop(const std::string& loopName, const std::string& path);
+    void endCapture(const std::string& loopName);
+    void setLoopClock(const std::string& loopName, std::shared_ptr<const VirtualClock> clock);
+    void stepLoop(const std::string& loopName, uint64_t cycle);
     
     // Module access
     template<typename T>
     std::shared_ptr<T> getModule(const std::string& name) {
+        loadIfDeferred(name);
         std::lock_guard<std::mutex> lock(modulesMutex_);
         auto it = modules_.find(name);
         if (it != modules_.end()) {
@@ -86,6 +311,30 @@ public:
         return nullptr;
     }
     
+    // Resolve a name to a typed handle once (locks, hashes and checks the type);
+    // returns an invalid handle if the module is missing or not a T
+    template<typename T>
+    ModuleHandle<T> resolveModule(const std::string& name) {
+        loadIfDeferred(name);
+        std::lock_guard<std::mutex> lock(modulesMutex_);
+        auto it = modules_.find(name);
+        if (it == modules_.end()) {
+            return {};
+        }
+        ModuleInfo& info = it->second;
+        if (!info.handle.isValid()) {
+            info.handle = moduleTable_.insert(info.module);
+        }
+        return moduleTable_.handleFor<T>(info.handle);
+    }
+    
+    // Hot-path lookup: one indexed load, nullptr once the module is unloaded.
+    // The pointer stays valid until the calling thread leaves its EpochGuard.
+    template<typename T>
+    T* getModule(ModuleHandle<T> handle) const {
+        return moduleTable_.get(handle);
+    }
+    
     // Error handling
     void setErrorCallback(ErrorCallback callback) { errorCallback_ = callback; }
     
@@ -97,38 +346,96 @@ private:
     // Module storage
     struct ModuleInfo {
         std::shared_ptr<Module> module;
-        void* libraryHandle;
+        void* libraryHandle;            // Closed by the module's deleter, after destroyModule
+        std::string libraryPath;
+        ModuleHandle<Module> handle;    // Slot in moduleTable_; unloadModule erases it
+        WatchId watch{INVALID_WATCH};   // Armed with watchTimeout while the system runs
+        std::chrono::microseconds watchTimeout{0};
+    };
+    
+    // A registered module not loaded yet; one of the two is set
+    struct DeferredModule {
         std::string libraryPath;
+        std::function<std::shared_ptr<Module>()> factory;
     };
     
     mutable std::mutex modulesMutex_;
     std::unordered_map<std::string, ModuleInfo> modules_;
+    std::unordered_map<std::string, DeferredModule> deferredModules_;   // Guarded by modulesMutex_
+    std::mutex deferredLoadMutex_;      // One lazy load at a time; taken before modulesMutex_
+    ModuleTable moduleTable_;           // Written under modulesMutex_, read lock-free
     
     // Control loops
     mutable std::mutex loopsMutex_;
     std::unordered_map<std::string, std::unique_ptr<ControlLoop>> controlLoops_;
+    std::unique_ptr<LoopScheduler> scheduler_;
     
     // IPC components
     std::shared_ptr<MessageQueue> messageQueue_;
     std::shared_ptr<SharedMemory> sharedMemory_;
+    std::shared_ptr<SensorBoard> sensorBoard_;
+    std::shared_ptr<SharedMemoryPool> sharedPool_;
     
     // Metrics
+    mutable std::mutex metricsMutex_;   // Guards metrics_ and metricsCallback_
     mutable SystemMetrics metrics_;
     std::function<void(const SystemMetrics&)> metricsCallback_;
     std::thread metricsThread_;
+    std::chrono::nanoseconds lastCpuTime_{0};           // Metrics thread only
+    std::chrono::steady_clock::time_point lastMetricsUpdate_;
     
     // Error handling
     ErrorCallback errorCallback_;
     
-    // Watchdog
-    std::thread watchdogThread_;
-    std::atomic<bool> watchdogRunning_{false};
+    FlightRecorder flightRecorder_;
+    std::atomic<uint32_t> flightDumps_{0};
+    std::atomic<int64_t> lastFaultDumpNs_{0};     // Rate-limits watchdog dumps only
+    // Automatic dumps are written here, not on the watchdog thread or in
+    // emergencyStop(); started on the first one
+    std::thread dumpThread_;
+    std::mutex dumpMutex_;
+    std::condition_variable dumpWake_;
+    std::vector<std::string> pendingDumps_;     // Reasons, oldest first
+    bool dumpStopping_{false};
+    
+    // Watchdog; declared last so its thread stops before anything its expiry
+    // callbacks touch is destroyed
+    Watchdog watchdog_{config_.watchdogTick};
     
     // Internal methods
-    void runControlLoop(ControlLoop* loop);
+    void runControlLoop(ControlLoop* loop);   // One cycle, released by scheduler_
+    void runMimoCycle(ControlLoop* loop);     // MIMO, and SISO through runSisoControl()
+    void runSisoControl(ControlLoop* loop, const SensorSnapshot& inputs);
+    // setControlFunction(): state owns what func refers to, if anything. A SISO
+    // function replaces any MIMO one, which would otherwise take precedence.
+    void installControl(const std::string& loopName, ActuatorCallback func, std::shared_ptr<void> state);
+    void installControl(const std::string& loopName, MimoControlFunction func, std::shared_ptr<void> state);
+    void finishCapture(const std::string& loopName, std::shared_ptr<ReplayWriter> capture);
+    void runEventLoop(ControlLoop* loop);     // Thread body of an event-driven loop, until !loop->running
+    void addAcquisitionTask(const std::string& sensorName);  // start(): poll a sensor only event loops read
+    void runDataflowCycle(ControlLoop* loop);
+    void prepareCycleBuffers(ControlLoop* loop);
+    void resolveLoopHandles(ControlLoop* loop);
+    void rebindLoops(const ModuleLoadReport& report);  // Loops wired to modules just loaded
+    LoopScheduler::Options schedulerOptions();
+    void setupRealtime();     // start(): after registering loops, before scheduler_->start()
+    std::vector<int> housekeepingCpus() const;  // Empty unless HOUSEKEEPING_OFF_RT
+    void reportRealtime(const std::string& error);
     void updateMetrics();
-    void watchdogMonitor();
+    void armLoop(ControlLoop* loop);  // Calibrate the clock and give the loop its default watch
+    void watchLoop(ControlLoop* loop, std::chrono::microseconds timeout);
+    void watchModule(ModuleInfo& info, std::chrono::microseconds timeout);
+    void armWatches(bool armed);    // start() and stop(): a stopped system has no deadlines
+    void onWatchdogExpiry(const std::string& name, uint64_t missedTicks);
+    void dumpOnFault(const std::string& reason);    // Automatic dumps; reports errors, never throws
+    void runDumps();                                // dumpThread_ body, until dumpStopping_ and drained
     bool validateModuleCompatibility(const Module* module);
+    
+    struct PendingModule;
+    void initializeBatch(std::vector<PendingModule>& pending, size_t threads,
+                         std::chrono::steady_clock::time_point batchStart, ModuleLoadReport& report);
+    bool swapModule(const std::string& name, PendingModule& entry);
+    void loadIfDeferred(const std::string& name);
     void handleError(const std::string& module, const std::string& error);
 };
 
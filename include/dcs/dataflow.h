@@ -0,0 +1,145 @@
+#pragma once
+
+#include "module.h"
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace dcs {
+
+class DataflowSchedule;
+
+// Directed graph of sensors, control nodes and actuators, e.g. a cascade
+// where an outer position controller feeds the setpoint of an inner
+// velocity controller. Every edge carries one SensorData sample.
+//
+// Declare nodes and edges, then compile() into a DataflowSchedule. Nodes run
+// at their own rate; rates must be harmonic (the fastest rate of a branch is
+// an integer multiple of every rate in it), and a node reading a slower
+// producer sees its latest output (sample and hold).
+class DataflowGraph {
+public:
+    using NodeId = uint32_t;
+    using SourceFunction = InplaceFunction<SensorData()>;
+    // inputs are in connect() order; outputs hold the node's previous outputs on entry
+    using ControlFunction = InplaceFunction<void(Span<const SensorData> inputs, Span<SensorData> outputs)>;
+    using SinkFunction = InplaceFunction<void(const ActuatorCommand& command)>;
+
+    enum class Kind {
+        SENSOR,
+        CONTROLLER,
+        ACTUATOR
+    };
+
+    struct Node {
+        std::string name;
+        Kind kind;
+        double rate;
+        size_t outputs;
+        std::vector<std::pair<NodeId, size_t>> inputs;  // (producer, output index)
+        SourceFunction read;
+        ControlFunction control;
+        SinkFunction write;
+    };
+
+    // Sensor and actuator IO may be bound later (ControlSystem binds them to
+    // the modules of the same name); compile() rejects unbound nodes
+    NodeId addSensor(const std::string& name, double rate, SourceFunction read = nullptr);
+    NodeId addController(const std::string& name, double rate, size_t outputs, ControlFunction control);
+    NodeId addActuator(const std::string& name, double rate, SinkFunction write = nullptr);
+
+    // Feed output `output` of `from` into the next input of `to`
+    void connect(NodeId from, NodeId to, size_t output = 0);
+
+    void bindSensor(NodeId sensor, SourceFunction read);
+    void bindActuator(NodeId actuator, SinkFunction write);
+
+    const std::vector<Node>& nodes() const { return nodes_; }
+
+    // Validate (no cycles, harmonic rates, every input wired, IO bound) and
+    // lay out the schedule; throws std::invalid_argument naming the problem
+    DataflowSchedule compile() const;
+
+private:
+    std::vector<Node> nodes_;
+
+    NodeId addNode(Node node);
+    Node& node(NodeId id, Kind kind, const char* what);
+};
+
+// Compiled form of a DataflowGraph.
+//
+// Weakly connected components share no data, so each becomes an independent
+// branch that may run on its own thread. Within a branch, nodes run in
+// topological order from one flat step array, and every node output and
+// every gathered input list has a fixed slot in one contiguous buffer laid
+// out in execution order, so a cycle allocates nothing and walks memory
+// front to back.
+class DataflowSchedule {
+public:
+    size_t branchCount() const { return branches_.size(); }
+    double branchRate(size_t branch) const { return branches_.at(branch).rate; }
+
+    // One cycle of a branch at its rate; runs the nodes due in that cycle.
+    // Distinct branches may run concurrently, one branch must not.
+    void runBranch(size_t branch, uint64_t cycle);
+
+    // Node names of a branch in execution order
+    std::vector<std::string> executionOrder(size_t branch) const;
+
+    // Latest value of a node output
+    const SensorData& output(DataflowGraph::NodeId node, size_t index = 0) const;
+
+    // Visit the samples read and the commands written by runBranch(branch,
+    // cycle), e.g. to record them; call before the branch runs again
+    template<typename OnSample, typename OnCommand>
+    void forEachIo(size_t branch, uint64_t cycle, OnSample&& onSample, OnCommand&& onCommand) const {
+        const Branch& b = branches_.at(branch);
+        for (size_t i = b.firstStep; i < b.firstStep + b.stepCount; ++i) {
+            const Step& step = steps_[i];
+            if (cycle % step.divisor != 0) {
+                continue;
+            }
+            if (step.kind == DataflowGraph::Kind::SENSOR) {
+                onSample(buffers_[step.outputSlot]);
+            } else if (step.kind == DataflowGraph::Kind::ACTUATOR) {
+                const SensorData& input = buffers_[sources_[step.gatherBegin]];
+                onCommand(ActuatorCommand(step.signal, input.value, input.unit));
+            }
+        }
+    }
+
+private:
+    friend class DataflowGraph;
+
+    struct Step {
+        DataflowGraph::Kind kind;
+        uint32_t node;
+        uint32_t divisor;           // Runs when cycle % divisor == 0
+        uint32_t gatherBegin;       // First of this step's producer slots in sources_
+        uint32_t inputSlot;         // First of this step's contiguous input slots in buffers_
+        uint32_t inputCount;
+        uint32_t outputSlot;
+        uint32_t outputCount;
+        SignalId signal;            // Actuator target
+    };
+
+    struct Branch {
+        double rate{0.0};
+        size_t firstStep{0};
+        size_t stepCount{0};
+    };
+
+    std::vector<std::string> names_;
+    std::vector<Step> steps_;
+    std::vector<uint32_t> sources_;     // Producer output slot for each gathered input
+    std::vector<SensorData> buffers_;
+    std::vector<uint32_t> outputSlots_; // First output slot by node id
+    std::vector<Branch> branches_;
+    std::vector<DataflowGraph::SourceFunction> reads_;     // Indexed by step
+    std::vector<DataflowGraph::ControlFunction> controls_;
+    std::vector<DataflowGraph::SinkFunction> writes_;
+};
+
+} // namespace dcs
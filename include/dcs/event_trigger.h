@@ -0,0 +1,51 @@
+#pragma once
+
+#include "sensor_board.h"
+#include "utils/wait.h"
+#include <chrono>
+#include <string>
+#include <vector>
+
+namespace dcs {
+
+// When an event-driven control loop runs
+struct TriggerPolicy {
+    std::vector<std::string> sensors;   // Sensors whose samples wake the loop, empty = all of its sensors
+    size_t quorum{1};                   // Fresh samples needed (from distinct sensors) before a cycle
+    std::chrono::microseconds minInterArrival{0};   // Earliest next cycle after one starts, bounds CPU load
+};
+
+// Blocks until enough watched signals on a SensorBoard have new samples.
+//
+// A signal counts as fresh when its board version moved since the last time
+// wait() fired. Sleeping is a futex wait keyed to the watched signals' slots,
+// so their publishes, from any thread or process, wake the waiter without
+// polling and other signals' publishes leave it asleep. Deadlines are
+// CLOCK_MONOTONIC (WaitStrategy::nowNs()), the clock the sleeps run on.
+class EventTrigger {
+public:
+    EventTrigger(const SensorBoard& board, std::vector<SignalId> signals, size_t quorum,
+                 std::chrono::nanoseconds minInterArrival = std::chrono::nanoseconds(0));
+
+    // Replace the watched signals; ones that stay watched keep their history
+    void setSignals(std::vector<SignalId> signals);
+    const std::vector<SignalId>& signals() const { return signals_; }
+
+    // True once a quorum is fresh (and minInterArrival has passed since the
+    // last firing); the fresh samples are then consumed. False on timeout.
+    bool wait(std::chrono::nanoseconds timeout);
+
+    // Watched signals with a sample not yet consumed
+    size_t freshCount() const;
+
+private:
+    const SensorBoard& board_;
+    std::vector<SignalId> signals_;
+    std::vector<uint64_t> consumed_;    // Board version of each signal at the last firing
+    size_t quorum_;
+    std::chrono::nanoseconds minInterArrival_;
+    int64_t lastFireNs_{0};
+    WaitStrategy sleeper_;      // SLEEP mode: the minInterArrival gap
+};
+
+} // namespace dcs
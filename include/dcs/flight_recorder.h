@@ -0,0 +1,108 @@
+#pragma once
+
+#include "module.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace dcs {
+
+// One sample entering or one command leaving a control loop
+struct FlightRecord {
+    enum Kind : uint8_t {
+        SAMPLE,
+        COMMAND
+    };
+
+    int64_t timestampNs;    // TscClock time since epoch
+    uint64_t cycle;
+    double value;
+    SignalId signal;
+    uint16_t channel;       // Recorder channel, one per loop
+    Kind kind;
+    uint8_t unit;           // Unit
+};
+
+static_assert(sizeof(FlightRecord) == 32, "FlightRecord must stay 32 bytes");
+static_assert(std::is_trivially_copyable<FlightRecord>::value, "FlightRecord must be trivially copyable");
+
+// Contents of a dump file, as read back by FlightRecorder::load()
+struct FlightDump {
+    std::string reason;
+    int64_t dumpTimeNs{0};
+    std::vector<std::string> channels;
+    std::unordered_map<SignalId, std::string> signals;
+    std::vector<FlightRecord> records;      // Ordered by timestamp
+};
+
+// Always-on, in-memory flight recorder for control loops.
+//
+// Each channel is a power-of-two ring of fixed-size binary records with a
+// single writer (the loop's cycle), so recording is a plain store and a
+// release of the head index: no lock and no shared cache line with other
+// loops. The rings keep the most recent records; dump() copies them, oldest
+// first across all channels, into a memory-mapped file together with the
+// channel and signal names needed to read it offline.
+class FlightRecorder {
+public:
+    class Channel {
+    public:
+        void recordSample(int64_t timestampNs, uint64_t cycle, const SensorData& sample) {
+            record(FlightRecord::SAMPLE, timestampNs, cycle, sample.id, sample.value, sample.unit);
+        }
+        void recordCommand(int64_t timestampNs, uint64_t cycle, const ActuatorCommand& command) {
+            record(FlightRecord::COMMAND, timestampNs, cycle, command.id, command.value, command.unit);
+        }
+
+        void record(FlightRecord::Kind kind, int64_t timestampNs, uint64_t cycle, SignalId signal, double value,
+                    Unit unit) {
+            uint64_t head = head_.load(std::memory_order_relaxed);
+            records_[head & mask_] =
+                FlightRecord{timestampNs, cycle, value, signal, index_, kind, static_cast<uint8_t>(unit)};
+            head_.store(head + 1, std::memory_order_release);
+        }
+
+        const std::string& name() const { return name_; }
+        uint64_t recorded() const { return head_.load(std::memory_order_acquire); }
+
+    private:
+        friend class FlightRecorder;
+
+        Channel(const std::string& name, uint16_t index, size_t capacity);
+
+        alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> head_{0};
+        uint64_t mask_;
+        std::unique_ptr<FlightRecord[]> records_;
+        uint16_t index_;
+        std::string name_;
+    };
+
+    // Add a ring keeping at least the last `records` records.
+    // The channel stays valid for the recorder's lifetime; call at setup.
+    Channel* addChannel(const std::string& name, size_t records);
+    size_t channelCount() const;
+
+    // Write the current contents of every ring to path (created or
+    // truncated) and return the number of records written. Safe while loops
+    // keep recording: records overwritten during the copy are left out.
+    // Throws FlightRecorderException on I/O errors.
+    size_t dump(const std::string& path, const std::string& reason) const;
+
+    static FlightDump load(const std::string& path);
+
+private:
+    mutable std::mutex mutex_;      // Guards the channel list, not the rings
+    std::vector<std::unique_ptr<Channel>> channels_;
+};
+
+class FlightRecorderException : public std::runtime_error {
+public:
+    explicit FlightRecorderException(const std::string& msg) : std::runtime_error(msg) {}
+};
+
+} // namespace dcs
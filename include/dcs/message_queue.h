@@ -0,0 +1,281 @@
+#pragma once
+
+#include "shared_memory.h"
+#include "utils/wait.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <string>
+#include <type_traits>
+
+namespace dcs {
+
+// Fixed-size IPC message, exactly one cache line so a slot never straddles two
+struct Message {
+    uint32_t topic{0};       // Signal or channel identifier
+    uint32_t source{0};      // Producing module identifier
+    uint64_t sequence{0};
+    int64_t timestampNs{0};
+    double value{0.0};
+    uint8_t payload[32]{};   // Small inline payload, interpretation is per-topic
+};
+
+static_assert(std::is_trivially_copyable<Message>::value, "Message must be trivially copyable");
+static_assert(sizeof(Message) == CACHE_LINE_SIZE, "Message must fill exactly one cache line");
+
+namespace detail {
+
+inline size_t roundUpPow2(size_t n) {
+    size_t p = 1;
+    while (p < n) {
+        p <<= 1;
+    }
+    return p;
+}
+
+// Producer and consumer indices live on separate cache lines to avoid false sharing
+struct alignas(CACHE_LINE_SIZE) RingIndex {
+    std::atomic<uint64_t> value{0};
+};
+
+struct RingHeader {
+    RingIndex head;                     // Next slot to read
+    RingIndex tail;                     // Next slot to write
+    alignas(CACHE_LINE_SIZE) uint64_t capacity{0};
+    std::atomic<uint64_t> dropped{0};   // Failed pushes, i.e. queue full
+};
+
+} // namespace detail
+
+// Bounded single-producer/single-consumer ring.
+//
+// The shared state (indices and slots) lives in caller-provided memory, which
+// may be a SharedMemory region; the producer and consumer each keep a private
+// cached copy of the other side's index so the common case touches only their
+// own cache line. Capacity is rounded up to a power of two.
+template<typename T>
+class SpscRing {
+    static_assert(std::is_trivially_copyable<T>::value, "Ring elements must be trivially copyable");
+
+public:
+    static size_t bytesFor(size_t capacity) {
+        return sizeof(detail::RingHeader) + detail::roundUpPow2(capacity) * sizeof(T);
+    }
+
+    SpscRing() = default;
+    SpscRing(void* memory, size_t capacity, bool initialize) { attach(memory, capacity, initialize); }
+
+    void attach(void* memory, size_t capacity, bool initialize) {
+        header_ = static_cast<detail::RingHeader*>(memory);
+        if (initialize) {
+            new (header_) detail::RingHeader();
+            header_->capacity = detail::roundUpPow2(capacity);
+        }
+        mask_ = header_->capacity - 1;
+        slots_ = reinterpret_cast<T*>(header_ + 1);
+        cachedHead_ = header_->head.value.load(std::memory_order_acquire);
+        cachedTail_ = header_->tail.value.load(std::memory_order_acquire);
+    }
+
+    bool tryPush(const T& item) {
+        uint64_t tail = header_->tail.value.load(std::memory_order_relaxed);
+        if (tail - cachedHead_ > mask_) {
+            cachedHead_ = header_->head.value.load(std::memory_order_acquire);
+            if (tail - cachedHead_ > mask_) {
+                header_->dropped.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+        }
+        slots_[tail & mask_] = item;
+        header_->tail.value.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool tryPop(T& item) {
+        uint64_t head = header_->head.value.load(std::memory_order_relaxed);
+        if (head == cachedTail_) {
+            cachedTail_ = header_->tail.value.load(std::memory_order_acquire);
+            if (head == cachedTail_) {
+                return false;
+            }
+        }
+        item = slots_[head & mask_];
+        header_->head.value.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    size_t size() const {
+        return header_->tail.value.load(std::memory_order_acquire) -
+               header_->head.value.load(std::memory_order_acquire);
+    }
+    size_t capacity() const { return mask_ + 1; }
+    uint64_t dropped() const { return header_->dropped.load(std::memory_order_relaxed); }
+
+private:
+    detail::RingHeader* header_{nullptr};
+    T* slots_{nullptr};
+    uint64_t mask_{0};
+    // Private to the producer and consumer respectively
+    alignas(CACHE_LINE_SIZE) uint64_t cachedHead_{0};
+    alignas(CACHE_LINE_SIZE) uint64_t cachedTail_{0};
+};
+
+// Bounded multi-producer/multi-consumer ring (Vyukov sequence-per-slot design).
+//
+// Each slot carries a sequence number telling producers and consumers whether
+// it is free for the current lap, so both sides claim slots with a single CAS
+// on their index and never block each other.
+template<typename T>
+class MpmcRing {
+    static_assert(std::is_trivially_copyable<T>::value, "Ring elements must be trivially copyable");
+
+    struct Slot {
+        std::atomic<uint64_t> sequence;
+        T data;
+    };
+
+public:
+    static size_t bytesFor(size_t capacity) {
+        return sizeof(detail::RingHeader) + detail::roundUpPow2(capacity) * sizeof(Slot);
+    }
+
+    MpmcRing() = default;
+    MpmcRing(void* memory, size_t capacity, bool initialize) { attach(memory, capacity, initialize); }
+
+    void attach(void* memory, size_t capacity, bool initialize) {
+        header_ = static_cast<detail::RingHeader*>(memory);
+        slots_ = reinterpret_cast<Slot*>(header_ + 1);
+        if (initialize) {
+            new (header_) detail::RingHeader();
+            header_->capacity = detail::roundUpPow2(capacity);
+            for (uint64_t i = 0; i < header_->capacity; ++i) {
+                new (&slots_[i].sequence) std::atomic<uint64_t>(i);
+            }
+        }
+        mask_ = header_->capacity - 1;
+    }
+
+    bool tryPush(const T& item) {
+        uint64_t pos = header_->tail.value.load(std::memory_order_relaxed);
+        Slot* slot;
+        for (;;) {
+            slot = &slots_[pos & mask_];
+            uint64_t seq = slot->sequence.load(std::memory_order_acquire);
+            auto diff = static_cast<int64_t>(seq - pos);
+            if (diff == 0) {
+                if (header_->tail.value.compare_exchange_weak(pos, pos + 1,
+                                                              std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                header_->dropped.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            } else {
+                pos = header_->tail.value.load(std::memory_order_relaxed);
+            }
+        }
+        slot->data = item;
+        slot->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool tryPop(T& item) {
+        uint64_t pos = header_->head.value.load(std::memory_order_relaxed);
+        Slot* slot;
+        for (;;) {
+            slot = &slots_[pos & mask_];
+            uint64_t seq = slot->sequence.load(std::memory_order_acquire);
+            auto diff = static_cast<int64_t>(seq - (pos + 1));
+            if (diff == 0) {
+                if (header_->head.value.compare_exchange_weak(pos, pos + 1,
+                                                              std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = header_->head.value.load(std::memory_order_relaxed);
+            }
+        }
+        item = slot->data;
+        slot->sequence.store(pos + mask_ + 1, std::memory_order_release);
+        return true;
+    }
+
+    size_t size() const {
+        uint64_t tail = header_->tail.value.load(std::memory_order_acquire);
+        uint64_t head = header_->head.value.load(std::memory_order_acquire);
+        return tail > head ? tail - head : 0;
+    }
+    size_t capacity() const { return mask_ + 1; }
+    uint64_t dropped() const { return header_->dropped.load(std::memory_order_relaxed); }
+
+private:
+    detail::RingHeader* header_{nullptr};
+    Slot* slots_{nullptr};
+    uint64_t mask_{0};
+};
+
+// Queue topology; SPSC is the fast path for a single sensor feeding a single loop
+enum class QueueMode {
+    SPSC,
+    MPMC
+};
+
+// Lock-free, bounded message queue for inter-module IPC.
+//
+// Backed by a named SharedMemory region when one is given (so other processes
+// mapping the segment can attach by name), otherwise by process-local memory.
+// send() never blocks: a full queue fails the send and bumps droppedCount().
+class MessageQueue {
+public:
+    // Process-local queue
+    explicit MessageQueue(size_t capacity, QueueMode mode = QueueMode::MPMC);
+
+    // Queue in the shared memory segment; attaches if the region already exists
+    MessageQueue(SharedMemory& shm, const std::string& name, size_t capacity,
+                 QueueMode mode = QueueMode::MPMC);
+
+    ~MessageQueue();
+
+    MessageQueue(const MessageQueue&) = delete;
+    MessageQueue& operator=(const MessageQueue&) = delete;
+
+    bool send(const Message& msg) {
+        return mode_ == QueueMode::SPSC ? spsc_.tryPush(msg) : mpmc_.tryPush(msg);
+    }
+
+    bool receive(Message& msg) {
+        return mode_ == QueueMode::SPSC ? spsc_.tryPop(msg) : mpmc_.tryPop(msg);
+    }
+    
+    // Wait up to timeout for a message, sleeping or spinning as the
+    // consumer's strategy says; false if none arrived
+    bool receive(Message& msg, std::chrono::nanoseconds timeout, WaitStrategy& wait) {
+        return wait.waitFor([this, &msg]() { return receive(msg); }, timeout.count());
+    }
+
+    size_t size() const { return mode_ == QueueMode::SPSC ? spsc_.size() : mpmc_.size(); }
+    size_t capacity() const { return mode_ == QueueMode::SPSC ? spsc_.capacity() : mpmc_.capacity(); }
+    uint64_t droppedCount() const {
+        return mode_ == QueueMode::SPSC ? spsc_.dropped() : mpmc_.dropped();
+    }
+    QueueMode getMode() const { return mode_; }
+
+    static size_t bytesFor(size_t capacity, QueueMode mode) {
+        return mode == QueueMode::SPSC ? SpscRing<Message>::bytesFor(capacity)
+                                       : MpmcRing<Message>::bytesFor(capacity);
+    }
+
+private:
+    QueueMode mode_;
+    void* localMemory_{nullptr};
+    SpscRing<Message> spsc_;
+    MpmcRing<Message> mpmc_;
+
+    void attach(void* memory, size_t capacity, bool initialize);
+};
+
+} // namespace dcs
@@ -7,6 +7,17 @@
 #include <vector>
 #include <atomic>
 #include <variant>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include "signal_registry.h"
+#include "utils/platform.h"
+#include "utils/span.h"
+#include "utils/inplace_function.h"
+#include "utils/clock.h"
+#include "utils/metrics.h"
+#include "payload.h"
+#include "watchdog.h"
 
 namespace dcs {
 
@@ -14,6 +25,7 @@ namespace dcs {
 class ControlSystem;
 class MessageQueue;
 class SharedMemory;
+class SensorBoard;
 
 // Data types
 enum class Unit {
@@ -31,25 +43,162 @@ enum class Unit {
     WATTS
 };
 
+// Fixed-size multi-axis value (IMU, pose, quaternion, rotation matrix),
+// contiguous and aligned for SIMD loads
+template<typename T, size_t N>
+struct alignas(sizeof(T) * N >= 32 ? 32 : 16) SampleVector {
+    static_assert(std::is_same<T, float>::value || std::is_same<T, double>::value,
+                  "Sample vectors hold float or double");
+    static constexpr size_t SIZE = N;
+    using value_type = T;
+    
+    T values[N];
+    
+    constexpr size_t size() const { return N; }
+    T* data() { return values; }
+    const T* data() const { return values; }
+    T& operator[](size_t i) { return values[i]; }
+    const T& operator[](size_t i) const { return values[i]; }
+};
+
+using Vec3f = SampleVector<float, 3>;
+using Vec4f = SampleVector<float, 4>;
+using Vec9f = SampleVector<float, 9>;
+using Vec3d = SampleVector<double, 3>;
+using Vec4d = SampleVector<double, 4>;
+using Vec9d = SampleVector<double, 9>;
+
+enum class SampleKind : uint8_t {
+    SCALAR,     // No components: the sample came from a scalar sensor
+    FLOAT32,
+    FLOAT64
+};
+
+// Per-sample structs are trivially copyable and fit in a cache line so they can
+// travel through lock-free queues and shared memory. Signals are identified by
+// interned SignalIds; the string constructors intern on every call and are a
+// setup/slow-path convenience only.
 struct SensorData {
-    std::string name;
-    double value;
-    Unit unit;
+    SignalId id{INVALID_SIGNAL};
+    Unit unit{Unit::NONE};
+    double value{0.0};
     std::chrono::steady_clock::time_point timestamp;
+    PayloadRef payload;     // Bulk data in the shared pool; read() hands its caller one reference
     
+    SensorData() = default;
+    SensorData(SignalId i, double v, Unit u = Unit::NONE)
+        : id(i), unit(u), value(v), timestamp(TscClock::now()) {}
     SensorData(const std::string& n, double v, Unit u = Unit::NONE)
-        : name(n), value(v), unit(u), timestamp(std::chrono::steady_clock::now()) {}
+        : SensorData(SignalRegistry::instance().intern(n), v, u) {}
+    
+    const std::string& name() const { return SignalRegistry::instance().name(id); }
+};
+
+// Multi-axis sample: up to 9 doubles or 18 floats sharing one timestamp,
+// stored inline and 32-byte aligned. Kept apart from SensorData so scalar
+// samples stay one cache line; loops carry them next to the scalar snapshot
+// (SensorSnapshot::vectors).
+struct alignas(32) VectorSample {
+    static constexpr size_t MAX_DOUBLES = 9;
+    static constexpr size_t MAX_FLOATS = 18;
+    
+    SignalId id{INVALID_SIGNAL};
+    Unit unit{Unit::NONE};
+    std::chrono::steady_clock::time_point timestamp;
+    uint8_t components{0};              // 0 = empty
+    SampleKind kind{SampleKind::SCALAR};
+    alignas(32) union {
+        double f64[MAX_DOUBLES];
+        float f32[MAX_FLOATS];
+    } samples;
+    
+    VectorSample() = default;
+    template<typename T, size_t N>
+    VectorSample(SignalId i, const SampleVector<T, N>& v, Unit u = Unit::NONE)
+        : id(i), unit(u), timestamp(TscClock::now()) {
+        set(v);
+    }
+    
+    template<typename T, size_t N>
+    void set(const SampleVector<T, N>& v) {
+        static_assert(N * sizeof(T) <= sizeof(samples), "Sample vector too large for VectorSample");
+        constexpr bool isFloat = std::is_same<T, float>::value;
+        for (size_t i = 0; i < N; ++i) {
+            if (isFloat) {
+                samples.f32[i] = static_cast<float>(v[i]);
+            } else {
+                samples.f64[i] = static_cast<double>(v[i]);
+            }
+        }
+        kind = isFloat ? SampleKind::FLOAT32 : SampleKind::FLOAT64;
+        components = static_cast<uint8_t>(N);
+    }
+    
+    void clear() {
+        components = 0;
+        kind = SampleKind::SCALAR;
+    }
+    bool empty() const { return components == 0; }
+    
+    // In-place views of the components; empty unless the sample holds that kind
+    Span<const double> doubles() const {
+        return kind == SampleKind::FLOAT64 ? Span<const double>(samples.f64, components) : Span<const double>();
+    }
+    Span<const float> floats() const {
+        return kind == SampleKind::FLOAT32 ? Span<const float>(samples.f32, components) : Span<const float>();
+    }
+    
+    // Copy out as V; false if the sample is not a V (kind and length must match)
+    template<typename V>
+    bool get(V& out) const {
+        constexpr bool isFloat = std::is_same<typename V::value_type, float>::value;
+        if (components != V::SIZE || kind != (isFloat ? SampleKind::FLOAT32 : SampleKind::FLOAT64)) {
+            return false;
+        }
+        for (size_t i = 0; i < V::SIZE; ++i) {
+            out[i] = isFloat ? static_cast<typename V::value_type>(samples.f32[i])
+                             : static_cast<typename V::value_type>(samples.f64[i]);
+        }
+        return true;
+    }
+    
+    // What scalar consumers see: the first component, same signal and timestamp
+    SensorData scalar() const {
+        SensorData data;
+        data.id = id;
+        data.unit = unit;
+        data.timestamp = timestamp;
+        if (kind == SampleKind::FLOAT32 && components) {
+            data.value = samples.f32[0];
+        } else if (kind == SampleKind::FLOAT64 && components) {
+            data.value = samples.f64[0];
+        }
+        return data;
+    }
 };
 
 struct ActuatorCommand {
-    std::string target;
-    double value;
-    Unit unit;
+    SignalId id{INVALID_SIGNAL};
+    Unit unit{Unit::NONE};
+    double value{0.0};
     
+    ActuatorCommand() = default;
+    ActuatorCommand(SignalId i, double v, Unit u = Unit::NONE)
+        : id(i), unit(u), value(v) {}
     ActuatorCommand(const std::string& t, double v, Unit u = Unit::NONE)
-        : target(t), value(v), unit(u) {}
+        : ActuatorCommand(SignalRegistry::instance().intern(t), v, u) {}
+    
+    const std::string& target() const { return SignalRegistry::instance().name(id); }
 };
 
+static_assert(std::is_trivially_copyable<SensorData>::value, "SensorData must be trivially copyable");
+static_assert(std::is_trivially_copyable<VectorSample>::value, "VectorSample must be trivially copyable");
+static_assert(std::is_trivially_copyable<ActuatorCommand>::value,
+              "ActuatorCommand must be trivially copyable");
+static_assert(sizeof(SensorData) <= CACHE_LINE_SIZE, "SensorData must fit in a cache line");
+static_assert(sizeof(VectorSample) <= 2 * CACHE_LINE_SIZE, "VectorSample must fit in two cache lines");
+static_assert(sizeof(ActuatorCommand) <= CACHE_LINE_SIZE, "ActuatorCommand must fit in a cache line");
+
 // Module states
 enum class ModuleState {
     UNINITIALIZED,
@@ -81,6 +230,18 @@ public:
     // Health check
     virtual bool isHealthy() const { return state_ == ModuleState::RUNNING; }
     
+    // Names of modules that must be initialized before this one
+    virtual std::vector<std::string> getDependencies() const { return {}; }
+    
+    // Hot-swap hook: called on the replacement after initialize() and before
+    // the swap, while `previous` is still serving loops; copy calibration,
+    // integrator state etc. Must not block.
+    virtual void adoptState(const Module& previous) { (void)previous; }
+    
+    // Watchdog deadline registered when the module is loaded; zero = not watched.
+    // Loops beat on the module's behalf whenever they read or drive it.
+    virtual std::chrono::microseconds getHeartbeatTimeout() const { return std::chrono::microseconds{0}; }
+    
     // Metrics
     struct Metrics {
         uint64_t processedCount{0};
@@ -88,15 +249,28 @@ public:
         double maxProcessingTime{0.0};
         uint64_t errorCount{0};
         double uptime{0.0};
+        LatencySummary processingLatency;   // Percentiles in nanoseconds
     };
     
-    Metrics getMetrics() const { return metrics_; }
+    Metrics getMetrics() const {
+        Metrics snapshot = metrics_;
+        snapshot.errorCount = processingHistogram_.errorCount();
+        snapshot.processingLatency = processingHistogram_.summary();
+        snapshot.processedCount = snapshot.processingLatency.count;
+        snapshot.avgProcessingTime = snapshot.processingLatency.mean * 1e-9;
+        snapshot.maxProcessingTime = static_cast<double>(snapshot.processingLatency.max) * 1e-9;
+        return snapshot;
+    }
+    
+    // Full processing-time distribution for arbitrary percentile queries
+    const ShardedLatencyHistogram& getProcessingHistogram() const { return processingHistogram_; }
     
 protected:
     std::string name_;
     std::string version_;
     std::atomic<ModuleState> state_{ModuleState::UNINITIALIZED};
     mutable Metrics metrics_;
+    ShardedLatencyHistogram processingHistogram_;
     
     // IPC handles
     std::shared_ptr<MessageQueue> messageQueue_;
@@ -104,10 +278,17 @@ protected:
     
     // Helper methods
     void setState(ModuleState state) { state_ = state; }
-    void updateMetrics(double processingTime);
+    // Record one operation that took processingTime seconds; wait-free, any thread
+    void updateMetrics(double processingTime) {
+        processingHistogram_.record(processingTime > 0.0 ? static_cast<uint64_t>(processingTime * 1e9 + 0.5) : 0);
+    }
+    void recordError() { processingHistogram_.recordError(); }
+    // Proof of life from the module's own threads; one relaxed store
+    void heartbeat() const { heartbeat_.beat(); }
     
 private:
     friend class ControlSystem;
+    Heartbeat heartbeat_;
     void setIPCHandles(std::shared_ptr<MessageQueue> mq, std::shared_ptr<SharedMemory> sm);
 };
 
@@ -118,6 +299,16 @@ public:
     
     // Sensor-specific interface
     virtual SensorData read() = 0;
+    
+    // read() and publish the sample to the attached sensor board, if any
+    SensorData poll();
+    // Same, and fill vector with a multi-axis sensor's full sample; cleared
+    // for scalar sensors. The board only ever gets the scalar view.
+    SensorData poll(VectorSample& vector);
+    // Signal of the last poll()ed sample, INVALID_SIGNAL before the first;
+    // where event-driven loops find this sensor on the board
+    SignalId publishedSignal() const { return publishedSignal_.load(std::memory_order_relaxed); }
+    void attachSensorBoard(std::shared_ptr<SensorBoard> board) { sensorBoard_ = std::move(board); }
     void setUpdateRate(double hz);
     double getUpdateRate() const { return updateRate_; }
     
@@ -127,10 +318,38 @@ public:
     
 protected:
     double updateRate_{10.0}; // Default 10Hz
+    std::shared_ptr<SensorBoard> sensorBoard_;
+    std::atomic<SignalId> publishedSignal_{INVALID_SIGNAL};
     
     // Hardware interface helpers
     virtual void connectHardware() {}
     virtual void disconnectHardware() {}
+    
+    // One read for poll(VectorSample&): multi-axis sensors fill vector and
+    // return its scalar view (see VectorSensorModule)
+    virtual SensorData readSample(VectorSample& vector) {
+        vector.clear();
+        return read();
+    }
+    
+private:
+    SensorData publish(const SensorData& data);
+};
+
+// Base for multi-axis sensors (IMU, pose, quaternion): readVector() returns one
+// timestamped vector; read() and scalar consumers see its first component
+class VectorSensorModule : public SensorModule {
+public:
+    using SensorModule::SensorModule;
+    
+    virtual VectorSample readVector() = 0;
+    SensorData read() override { return readVector().scalar(); }
+    
+protected:
+    SensorData readSample(VectorSample& vector) override {
+        vector = readVector();
+        return vector.scalar();
+    }
 };
 
 // Actuator module specialization
@@ -156,12 +375,46 @@ public:
     void setLimits(const Limits& limits) { limits_ = limits; }
     Limits getLimits() const { return limits_; }
     
+    // Batch path for actuator groups (valve banks, motor groups), where
+    // commands[i] drives channel i. Limits apply to the whole group in SIMD:
+    // each value's change from the channel's last applied value is capped at
+    // maxRate * dt, then the value is clamped to [minValue, maxValue]; NaN
+    // holds the last value. Channels are keyed by command id, so the group
+    // may change between batches; a channel not in the previous batch is
+    // only clamped. dt is the real time since the previous batch, or given
+    // explicitly. The limited commands go to applyBatch(). Returns the indices
+    // that were changed, valid until the next call; nothing is applied while
+    // emergency-stopped.
+    Span<const uint32_t> executeBatch(Span<const ActuatorCommand> commands);
+    Span<const uint32_t> executeBatch(Span<const ActuatorCommand> commands, double dt);
+    
 protected:
     std::atomic<bool> emergencyStop_{false};
     Limits limits_;
     
     // Command validation
     bool validateCommand(const ActuatorCommand& cmd) const;
+    
+    // Drive a whole group with commands already within limits. The default
+    // calls execute() per command; drivers override it to write the group
+    // in one bus transaction.
+    virtual void applyBatch(Span<const ActuatorCommand> commands);
+    
+private:
+    // Reused across batches so a steady group size never allocates
+    struct BatchState {
+        std::vector<double> values;         // Requested, then limited, values
+        std::vector<double> lastApplied;    // By channel, in the previous batch's order
+        std::vector<SignalId> channels;     // Command id of each lastApplied entry
+        std::vector<uint32_t> fresh;        // Channels of this batch with no history
+        std::vector<uint64_t> clampedBits;
+        std::vector<uint32_t> clamped;
+        std::vector<ActuatorCommand> limited;
+        TscClock::time_point lastBatch{};
+    };
+    BatchState batch_;
+
+    void remapHistory(Span<const ActuatorCommand> commands);
 };
 
 // Module registration macro
@@ -178,9 +431,25 @@ protected:
         } \
     }
 
-// Callback types
+// Callback types. ActuatorCallback runs every cycle, so it never allocates; a
+// callable too large for its inline buffer fails to compile
+// (ControlSystem::setControlFunction takes any size).
 using SensorCallback = std::function<void(const SensorData&)>;
-using ActuatorCallback = std::function<ActuatorCommand(const SensorData&)>;
+using ActuatorCallback = InplaceFunction<ActuatorCommand(const SensorData&)>;
 using ErrorCallback = std::function<void(const std::string& module, const std::string& error)>;
 
+// Time-coherent view of every sensor in a control loop, captured back-to-back
+// at the start of a cycle. samples[i] belongs to ControlLoop::sensorModules[i].
+struct SensorSnapshot {
+    Span<const SensorData> samples;
+    Span<const VectorSample> vectors;   // vectors[i] is samples[i] in full; empty() for scalar sensors
+    std::chrono::steady_clock::time_point timestamp;
+    uint64_t cycle{0};
+};
+
+// Multi-input/multi-output control function. commands[i] is pre-filled with the
+// target and last value of ControlLoop::actuatorModules[i]; the function
+// overwrites the values it wants to change. Both buffers are owned by the loop.
+using MimoControlFunction = InplaceFunction<void(const SensorSnapshot& inputs, Span<ActuatorCommand> commands)>;
+
 } // namespace dcs
@@ -0,0 +1,170 @@
+#pragma once
+
+#include "module.h"
+#include "utils/epoch.h"
+#include <atomic>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+namespace dcs {
+
+// Resolve-once reference to a module slot. The generation detects a slot that
+// has since been emptied or reused, so a stale handle resolves to nullptr
+// instead of to someone else's module.
+template<typename T>
+struct ModuleHandle {
+    static constexpr uint32_t INVALID_INDEX = 0xFFFFFFFFu;
+
+    uint32_t index{INVALID_INDEX};
+    uint32_t generation{0};
+
+    bool isValid() const { return index != INVALID_INDEX; }
+
+    // Handles convert towards the base class only
+    template<typename U, typename = std::enable_if_t<std::is_base_of<T, U>::value>>
+    ModuleHandle(const ModuleHandle<U>& other) : index(other.index), generation(other.generation) {}
+    ModuleHandle() = default;
+    ModuleHandle(uint32_t i, uint32_t g) : index(i), generation(g) {}
+};
+
+// Read-mostly slab of loaded modules.
+//
+// Lookups through a handle are one indexed load plus a generation check: no
+// lock, no hashing, no RTTI. The type is checked once, when the handle is
+// made; replace() keeps that check true for handles typed on Module,
+// SensorModule or ActuatorModule by retiring the generation when the module
+// changes kind. Handles typed on a concrete class can see a same-kind swap
+// to another class, so they pay a dynamic_cast per lookup. Writers
+// (serialized by the caller) publish new modules with a release store and
+// retire removed ones through the EpochDomain, so a loop thread inside an
+// EpochGuard can keep using a module it looked up until it leaves the guard.
+class ModuleTable {
+public:
+    explicit ModuleTable(size_t capacity = 1024)
+        : capacity_(capacity), slots_(new Slot[capacity]), owners_(capacity) {}
+
+    ModuleTable(const ModuleTable&) = delete;
+    ModuleTable& operator=(const ModuleTable&) = delete;
+
+    // Reader side, call inside an EpochGuard
+    template<typename T>
+    T* get(ModuleHandle<T> handle) const {
+        if (handle.index >= capacity_) {
+            return nullptr;
+        }
+        const Slot& slot = slots_[handle.index];
+        Module* module = slot.module.load(std::memory_order_acquire);
+        if (slot.generation.load(std::memory_order_relaxed) != handle.generation) {
+            return nullptr;
+        }
+        if (!followsSwaps<T>()) {
+            return dynamic_cast<T*>(module);
+        }
+        return static_cast<T*>(module);
+    }
+
+    // Writer side; callers serialize these (ControlSystem holds modulesMutex_)
+    ModuleHandle<Module> insert(std::shared_ptr<Module> module) {
+        uint32_t index;
+        if (!freeList_.empty()) {
+            index = freeList_.back();
+            freeList_.pop_back();
+        } else if (used_ < capacity_) {
+            index = static_cast<uint32_t>(used_++);
+        } else {
+            throw std::length_error("Module table full");
+        }
+        Slot& slot = slots_[index];
+        owners_[index] = std::move(module);
+        slot.module.store(owners_[index].get(), std::memory_order_release);
+        return {index, slot.generation.load(std::memory_order_relaxed)};
+    }
+
+    // Point an existing slot at a new module. Live handles follow the swap
+    // unless the module changes kind (sensor, actuator, other), which stales
+    // them all. Returns the slot's handle from now on.
+    ModuleHandle<Module> replace(ModuleHandle<Module> handle, std::shared_ptr<Module> module) {
+        checkLive(handle);
+        Slot& slot = slots_[handle.index];
+        if (kindOf(owners_[handle.index].get()) != kindOf(module.get())) {
+            slot.generation.fetch_add(1, std::memory_order_relaxed);
+        }
+        std::shared_ptr<Module> old = std::move(owners_[handle.index]);
+        owners_[handle.index] = std::move(module);
+        // Release orders the generation bump before the new module
+        slot.module.store(owners_[handle.index].get(), std::memory_order_release);
+        retire(std::move(old));
+        return {handle.index, slot.generation.load(std::memory_order_relaxed)};
+    }
+
+    // Empty a slot; outstanding handles to it resolve to nullptr from now on
+    void erase(ModuleHandle<Module> handle) {
+        checkLive(handle);
+        Slot& slot = slots_[handle.index];
+        slot.generation.fetch_add(1, std::memory_order_release);
+        slot.module.store(nullptr, std::memory_order_release);
+        retire(std::move(owners_[handle.index]));
+        freeList_.push_back(handle.index);
+    }
+
+    // Typed handle for a slot, checking the dynamic type once (the only RTTI use)
+    template<typename T>
+    ModuleHandle<T> handleFor(ModuleHandle<Module> handle) const {
+        checkLive(handle);
+        if (!std::is_same<T, Module>::value && !dynamic_cast<T*>(owners_[handle.index].get())) {
+            return {};
+        }
+        return {handle.index, handle.generation};
+    }
+
+    std::shared_ptr<Module> owner(ModuleHandle<Module> handle) const {
+        checkLive(handle);
+        return owners_[handle.index];
+    }
+
+    size_t capacity() const { return capacity_; }
+
+private:
+    struct alignas(CACHE_LINE_SIZE) Slot {
+        std::atomic<Module*> module{nullptr};
+        std::atomic<uint32_t> generation{0};
+    };
+
+    // Handle types that replace() keeps valid without a per-lookup check
+    template<typename T>
+    static constexpr bool followsSwaps() {
+        return std::is_same<T, Module>::value || std::is_same<T, SensorModule>::value ||
+               std::is_same<T, ActuatorModule>::value;
+    }
+
+    static int kindOf(const Module* module) {
+        if (dynamic_cast<const SensorModule*>(module)) {
+            return 1;
+        }
+        return dynamic_cast<const ActuatorModule*>(module) ? 2 : 0;
+    }
+
+    size_t capacity_;
+    std::unique_ptr<Slot[]> slots_;
+    // Writer-side state, never touched by readers
+    std::vector<std::shared_ptr<Module>> owners_;
+    std::vector<uint32_t> freeList_;
+    size_t used_{0};
+
+    void checkLive(ModuleHandle<Module> handle) const {
+        if (handle.index >= used_ || !owners_[handle.index] ||
+            slots_[handle.index].generation.load(std::memory_order_relaxed) != handle.generation) {
+            throw std::invalid_argument("Stale module handle");
+        }
+    }
+
+    static void retire(std::shared_ptr<Module> module) {
+        if (module) {
+            // The last reference is dropped only after every reader has moved on
+            EpochDomain::instance().retire([module = std::move(module)]() mutable { module.reset(); });
+        }
+    }
+};
+
+} // namespace dcs
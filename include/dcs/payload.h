@@ -0,0 +1,84 @@
+#pragma once
+
+#include "shared_memory_pool.h"
+#include "utils/span.h"
+#include <atomic>
+#include <cstdint>
+
+namespace dcs {
+
+// Trivially copyable reference to a payload in the shared memory segment, the
+// form a payload takes inside SensorData, Messages and other shared structs.
+// Whether it carries a reference is a matter of contract: one made by
+// SharedPayload::share() does and must be adopted exactly once, one made by
+// SharedPayload::ref() is only borrowed.
+struct PayloadRef {
+    uint64_t offset{0};     // Segment offset of the payload header, 0 = none
+    uint64_t size{0};
+
+    explicit operator bool() const { return offset != 0; }
+};
+
+// Reference-counted, zero-copy buffer in a SharedMemoryPool for large samples
+// such as images and point clouds.
+//
+// The producer fills the buffer while it holds the only reference, then hands
+// out references; every consumer reads the same bytes in place. The count
+// lives in the segment, so references may cross processes, and the block goes
+// back to the pool when the last one is released.
+class SharedPayload {
+public:
+    SharedPayload() = default;
+    ~SharedPayload() { reset(); }
+
+    SharedPayload(const SharedPayload& other);
+    SharedPayload& operator=(const SharedPayload& other);
+    SharedPayload(SharedPayload&& other) noexcept;
+    SharedPayload& operator=(SharedPayload&& other) noexcept;
+
+    // Uninitialized buffer of size bytes; throws SharedMemoryException when the pool is exhausted
+    static SharedPayload create(SharedMemoryPool& pool, size_t size,
+                                uint32_t owner = SharedMemoryPool::SHARED_OWNER);
+
+    // Take over the reference a share() ref carries
+    static SharedPayload adopt(SharedMemoryPool& pool, PayloadRef ref);
+
+    // New reference from a borrowed ref; the lender must hold one meanwhile
+    static SharedPayload retain(SharedMemoryPool& pool, PayloadRef ref);
+
+    // Read-only view through a borrowed ref, no reference taken
+    static Span<const uint8_t> view(const SharedMemoryPool& pool, PayloadRef ref);
+
+    // Ref carrying a new reference, for passing through queues and samples
+    PayloadRef share() const;
+    // Borrowed ref; valid while this handle (or another reference) lives
+    PayloadRef ref() const;
+
+    Span<const uint8_t> view() const;
+    // Mutable access for the producer; throws std::logic_error once shared
+    Span<uint8_t> writable();
+
+    size_t size() const { return header_ ? header_->size : 0; }
+    uint32_t useCount() const { return header_ ? header_->refs.load(std::memory_order_relaxed) : 0; }
+    explicit operator bool() const { return header_ != nullptr; }
+
+    void reset();
+
+private:
+    struct alignas(CACHE_LINE_SIZE) Header {
+        std::atomic<uint32_t> refs;
+        uint64_t size;
+    };
+
+    SharedMemoryPool* pool_{nullptr};
+    Header* header_{nullptr};
+
+    SharedPayload(SharedMemoryPool* pool, Header* header) : pool_(pool), header_(header) {}
+
+    static Header* headerAt(const SharedMemoryPool& pool, PayloadRef ref) {
+        return pool.resolve(OffsetPtr<Header>{ref.offset});
+    }
+    uint8_t* bytes() const { return reinterpret_cast<uint8_t*>(header_ + 1); }
+};
+
+} // namespace dcs
@@ -0,0 +1,84 @@
+#pragma once
+
+#include "utils/platform.h"
+#include "utils/span.h"
+#include <cstddef>
+#include <vector>
+
+namespace dcs {
+
+struct PidGains {
+    double kp{0.0};
+    double ki{0.0};
+    double kd{0.0};
+    double integralLimit{50.0};     // Anti-windup: the integral is clamped to ±integralLimit
+    double alpha{0.1};              // Derivative filter coefficient, 1 = unfiltered
+    double outputMin{0.0};
+    double outputMax{100.0};
+};
+
+// One PID controller with anti-windup and a filtered derivative. This is the
+// reference semantics: PidBank produces bit-identical outputs and state.
+class PidController {
+public:
+    explicit PidController(const PidGains& gains) : gains_(gains) {}
+    PidController(double kp, double ki, double kd);
+
+    double calculate(double setpoint, double measurement, double dt);
+    void reset();
+
+    const PidGains& gains() const { return gains_; }
+    void setGains(const PidGains& gains) { gains_ = gains; }
+
+private:
+    PidGains gains_;
+    double integral_{0.0};
+    double lastError_{0.0};
+    double lastDerivative_{0.0};
+};
+
+// Many PID controllers evaluated together.
+//
+// Gains and state are kept as structure-of-arrays, so update() runs 8
+// controllers per instruction with AVX-512, 4 with AVX2, or one at a time
+// otherwise; the best the CPU supports is picked at construction. Every
+// path evaluates the same operations in the same order as PidController
+// (no fused multiply-add), so results do not depend on the instruction set.
+class PidBank {
+public:
+    using Isa = SimdLevel;
+
+    // Returns the controller's index
+    size_t add(const PidGains& gains);
+    size_t size() const { return kp_.size(); }
+    void reserve(size_t count);
+
+    void setGains(size_t index, const PidGains& gains);
+    PidGains gains(size_t index) const;
+    void reset(size_t index);
+    void reset();
+
+    // Step every controller once: outputs[i] = controller i on
+    // (setpoints[i], measurements[i]). Each span must have size() elements;
+    // throws std::invalid_argument otherwise.
+    void update(Span<const double> setpoints, Span<const double> measurements, double dt, Span<double> outputs);
+
+    static Isa bestIsa();
+    Isa isa() const { return isa_; }
+    // Force an instruction set, e.g. to compare paths; throws
+    // std::invalid_argument if the CPU does not support it
+    void setIsa(Isa isa);
+
+private:
+    // Gains
+    std::vector<double> kp_, ki_, kd_;
+    std::vector<double> integralMin_, integralMax_;
+    std::vector<double> alpha_;
+    std::vector<double> outputMin_, outputMax_;
+    // State
+    std::vector<double> integral_, lastError_, lastDerivative_;
+
+    Isa isa_{bestIsa()};
+};
+
+} // namespace dcs
@@ -0,0 +1,215 @@
+#pragma once
+
+#include "control_system.h"
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace dcs {
+
+// What a capture was taken from: the loop and its wiring, in loop order
+struct ReplayHeader {
+    std::string loop;
+    double frequency{0.0};
+    std::vector<std::string> sensors;
+    std::vector<std::string> actuators;
+};
+
+// One captured cycle: the snapshot the control function saw and the
+// commands it produced. Signal ids are already mapped into this process.
+struct ReplayCycle {
+    uint64_t cycle{0};
+    TscClock::time_point timestamp;     // SensorSnapshot::timestamp
+    bool controlFailed{false};          // The control function threw; commands are empty
+    std::vector<SensorData> samples;    // Payloads are not captured
+    std::vector<VectorSample> vectors;  // vectors[i] belongs to samples[i], empty() if scalar
+    std::vector<ActuatorCommand> commands;
+};
+
+// Streams a loop's cycles to a capture file.
+//
+// append() runs on the loop's cycle: it encodes into a memory buffer under an
+// uncontended lock and a background thread writes the buffer out, so the
+// cycle never waits on the disk. Nothing is dropped; if the disk falls behind
+// the buffer grows. The format is a header followed by self-delimiting
+// frames, so a capture cut short by a crash replays up to its last whole cycle.
+class ReplayWriter {
+public:
+    // Creates (or truncates) path and writes the header; throws ReplayException
+    ReplayWriter(const std::string& path, const ReplayHeader& header);
+    ~ReplayWriter();
+
+    ReplayWriter(const ReplayWriter&) = delete;
+    ReplayWriter& operator=(const ReplayWriter&) = delete;
+
+    // vectors is parallel to samples, or empty if the loop has no multi-axis sensors
+    void append(uint64_t cycle, TscClock::time_point timestamp, Span<const SensorData> samples,
+                Span<const VectorSample> vectors, Span<const ActuatorCommand> commands, bool controlFailed);
+
+    // Block until everything appended so far is written; throws
+    // ReplayException if a write failed (later cycles are discarded)
+    void flush();
+
+    uint64_t cycles() const;
+    const std::string& path() const { return path_; }
+
+private:
+    void encodeSignal(SignalId id);
+    void writerThread();
+
+    std::string path_;
+    int fd_{-1};
+    mutable std::mutex mutex_;
+    std::condition_variable wake_;      // Buffer filling up or stopping
+    std::condition_variable written_;   // Writer caught up
+    std::vector<char> pending_;
+    std::vector<bool> namedSignals_;    // Indexed by SignalId; name frame already emitted
+    uint64_t cycles_{0};
+    uint64_t appendedBytes_{0};
+    uint64_t writtenBytes_{0};
+    std::string error_;
+    uint32_t flushWaiters_{0};
+    bool stopping_{false};
+    std::thread thread_;
+};
+
+// Reads a capture file one cycle at a time; a day-long capture never has to
+// fit in memory. Signal names are interned as they appear in the file.
+class ReplayReader {
+public:
+    // Throws ReplayException if path is missing or not a capture
+    explicit ReplayReader(const std::string& path);
+
+    const ReplayHeader& header() const { return header_; }
+
+    // Fill cycle with the next captured cycle, reusing its buffers; false at
+    // the end of the capture. Throws ReplayException on a corrupt frame.
+    bool next(ReplayCycle& cycle);
+
+    // The capture ended in a partial frame (the writer did not finish)
+    bool truncated() const { return truncated_; }
+
+private:
+    bool readFrame(uint32_t& type);
+
+    std::ifstream in_;
+    std::vector<char> buffer_;
+    std::vector<char> frame_;
+    ReplayHeader header_;
+    std::vector<SignalId> signalMap_;   // File id -> id in this process
+    bool truncated_{false};
+};
+
+// Replay stand-in for a sensor: read() returns whatever the Replayer staged
+// for the current cycle, multi-axis sample included
+class ReplaySensor : public SensorModule {
+public:
+    explicit ReplaySensor(const std::string& name) : SensorModule(name, "replay") {}
+
+    void initialize() override { setState(ModuleState::READY); }
+    SensorData read() override { return staged_; }
+
+    void stage(const SensorData& sample, const VectorSample& vector = VectorSample{}) {
+        staged_ = sample;
+        stagedVector_ = vector;
+    }
+
+protected:
+    SensorData readSample(VectorSample& vector) override {
+        vector = stagedVector_;
+        return staged_;
+    }
+
+private:
+    SensorData staged_;
+    VectorSample stagedVector_;
+};
+
+// Capture stand-in for an actuator: keeps the last command and counts them
+// instead of driving hardware. Accepts every command, limits included, so
+// what is compared is exactly what the control function produced.
+class CaptureActuator : public ActuatorModule {
+public:
+    explicit CaptureActuator(const std::string& name) : ActuatorModule(name, "replay") {}
+
+    void initialize() override { setState(ModuleState::READY); }
+    void execute(const ActuatorCommand& cmd) override {
+        last_ = cmd;
+        count_++;
+    }
+    bool isSafeToExecute(const ActuatorCommand&) const override { return true; }
+
+    const ActuatorCommand& lastCommand() const { return last_; }
+    uint64_t commandCount() const { return count_; }
+
+private:
+    ActuatorCommand last_;
+    uint64_t count_{0};
+};
+
+struct ReplayResult {
+    uint64_t cycles{0};
+    uint64_t mismatches{0};             // Cycles whose commands were not bit-identical
+    uint64_t firstMismatchCycle{0};     // Captured cycle number
+    std::string firstMismatch;          // What differed, empty if nothing did
+    bool truncated{false};              // See ReplayReader::truncated()
+    std::chrono::nanoseconds capturedTime{0};   // First to last replayed cycle
+    std::chrono::nanoseconds wallTime{0};
+
+    bool identical() const { return mismatches == 0; }
+    // Capture time replayed per second of wall time
+    double speedup() const {
+        return wallTime.count() > 0 ? static_cast<double>(capturedTime.count()) / wallTime.count() : 0.0;
+    }
+};
+
+// Deterministic replay of a capture into the same control function.
+//
+// attach() loads a ReplaySensor and a CaptureActuator for every module the
+// captured loop was wired to, under the same names, and recreates the loop
+// on a VirtualClock; then set the loop's control function as in production.
+// run() steps the loop synchronously, once per captured cycle with the
+// captured cycle number and timestamp and the captured samples, and compares
+// each command with the captured one bit for bit. Nothing sleeps, so replay
+// runs as fast as the control function does.
+//
+// Control functions replay deterministically when they depend only on their
+// inputs (samples, SensorSnapshot::timestamp and cycle) and their own state,
+// and when the capture started with a fresh loop and control function.
+class Replayer {
+public:
+    explicit Replayer(const std::string& path) : reader_(path) {}
+
+    const ReplayHeader& header() const { return reader_.header(); }
+    const VirtualClock& clock() const { return *clock_; }
+
+    // Target system must not be running; throws ControlSystemException if the
+    // stand-ins cannot be loaded (e.g. a module of that name already exists)
+    void attach(ControlSystem& system);
+
+    // Replay up to maxCycles more cycles; may be called repeatedly
+    ReplayResult run(uint64_t maxCycles = UINT64_MAX);
+
+private:
+    bool compare(const ReplayCycle& cycle, const std::vector<uint64_t>& countsBefore, std::string& what) const;
+
+    ReplayReader reader_;
+    ControlSystem* system_{nullptr};
+    std::shared_ptr<VirtualClock> clock_{std::make_shared<VirtualClock>()};
+    std::vector<std::shared_ptr<ReplaySensor>> sensors_;
+    std::vector<std::shared_ptr<CaptureActuator>> actuators_;
+    ReplayCycle cycle_;
+};
+
+class ReplayException : public std::runtime_error {
+public:
+    explicit ReplayException(const std::string& msg) : std::runtime_error(msg) {}
+};
+
+} // namespace dcs
@@ -0,0 +1,136 @@
+#pragma once
+
+#include "utils/platform.h"
+#include "utils/wait.h"
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace dcs {
+
+// What a periodic task does with releases that passed while a cycle overran
+enum class OverrunPolicy {
+    SKIP,       // Drop them and resume on the original phase
+    CATCH_UP,   // Run them back to back, at most maxCatchUp, then resume on phase
+    DEGRADE     // Drop them and halve the rate; restore it after recoveryCycles on time
+};
+
+struct TimingPolicy {
+    OverrunPolicy overrun{OverrunPolicy::SKIP};
+    int64_t deadlineNs{0};          // Relative to release, 0 = one period
+    uint32_t maxCatchUp{10};        // CATCH_UP: backlog bound, older releases are dropped
+    uint32_t maxRateDivisor{8};     // DEGRADE: lowest rate as a divisor of the nominal one
+    uint32_t recoveryCycles{100};   // DEGRADE: on-time cycles before doubling the rate again
+};
+
+// Timing counters for one periodic task, all in nanoseconds
+struct LoopTimingStats {
+    uint64_t cycles{0};
+    uint64_t overruns{0};       // Releases dropped because a cycle ran past its period
+    uint64_t missedDeadlines{0};    // Cycles that completed after release + deadline
+    int64_t lastJitterNs{0};    // Start time minus release time of the last cycle
+    int64_t maxJitterNs{0};
+    double avgJitterNs{0.0};
+    int64_t maxExecutionNs{0};
+    int64_t maxResponseNs{0};   // Worst-case response time, release to completion
+    uint32_t rateDivisor{1};    // Current DEGRADE slowdown, 1 = nominal rate
+};
+
+// Rate-monotonic scheduler multiplexing periodic tasks onto a fixed pool of
+// worker threads.
+//
+// Tasks are partitioned across workers once at start(): highest-rate tasks
+// first, each onto the worker with the lowest accumulated rate. Every worker
+// then sleeps until the earliest release among its tasks with an absolute
+// clock_nanosleep(TIMER_ABSTIME) and runs every due task in rate-monotonic
+// order (higher frequency first). Releases are computed from the original
+// phase, so wake-up latency never accumulates into drift. A cycle that runs
+// past its next release is handled by the task's OverrunPolicy, and one that
+// completes after its deadline is counted as a miss.
+class LoopScheduler {
+public:
+    using Task = std::function<void()>;
+
+    struct Options {
+        size_t workerCount{0};        // 0 = std::thread::hardware_concurrency()
+        std::vector<int> cpus;        // Worker i is pinned to cpus[i % cpus.size()]
+        size_t prefaultStackBytes{0}; // Stack each worker faults in before its first cycle
+        WaitOptions wait;             // How workers wait for releases; mode is the task default
+        // Called from start() for each affinity/priority that could not be applied
+        std::function<void(const std::string&)> onSetupWarning;
+    };
+
+    explicit LoopScheduler(const Options& options);
+    ~LoopScheduler();
+
+    LoopScheduler(const LoopScheduler&) = delete;
+    LoopScheduler& operator=(const LoopScheduler&) = delete;
+
+    // Register a periodic task; only valid before start(). Returns its index.
+    size_t addTask(const std::string& name, double frequency, Task task,
+                   const TimingPolicy& policy = TimingPolicy{});
+
+    // SCHED_FIFO priority (1-99) for a task, 0 = SCHED_OTHER; only valid
+    // before start(). A worker runs at the highest priority of its tasks.
+    void setPriority(size_t task, int priority);
+    
+    // How a task's worker waits for its releases; only valid before start().
+    // A worker uses the most eager mode of its tasks, so spinning stays on
+    // the workers (and pinned cores) of the tasks that asked for it.
+    void setWaitMode(size_t task, WaitMode mode);
+    
+    void start();
+    void stop();
+    bool isRunning() const { return running_; }
+
+    size_t taskCount() const { return tasks_.size(); }
+    size_t workerCount() const { return workerCount_; }
+    LoopTimingStats getStats(size_t task) const;
+
+    // CLOCK_MONOTONIC in nanoseconds, the time base of all releases
+    static int64_t nowNs();
+
+private:
+    struct alignas(CACHE_LINE_SIZE) TaskState {
+        std::string name;
+        int64_t periodNs{0};
+        double frequency{0.0};
+        Task task;
+        TimingPolicy policy;
+        int priority{0};
+        WaitMode waitMode{WaitMode::SLEEP};
+        int64_t deadlineNs{0};
+        int64_t nextReleaseNs{0};   // Owned by the worker thread
+        uint32_t onTimeCycles{0};   // Owned by the worker thread
+
+        std::atomic<uint64_t> cycles{0};
+        std::atomic<uint64_t> overruns{0};
+        std::atomic<uint64_t> missedDeadlines{0};
+        std::atomic<int64_t> maxResponseNs{0};
+        std::atomic<uint32_t> rateDivisor{1};
+        std::atomic<int64_t> lastJitterNs{0};
+        std::atomic<int64_t> maxJitterNs{0};
+        std::atomic<int64_t> totalJitterNs{0};
+        std::atomic<int64_t> maxExecutionNs{0};
+    };
+
+    std::vector<std::unique_ptr<TaskState>> tasks_;
+    std::vector<std::vector<TaskState*>> partitions_;
+    std::vector<std::thread> workers_;
+    std::vector<int> cpus_;
+    size_t prefaultStackBytes_;
+    WaitOptions waitOptions_;
+    std::function<void(const std::string&)> onSetupWarning_;
+    size_t workerCount_;
+    std::atomic<bool> running_{false};
+
+    void partition();
+    void runWorker(size_t worker);
+    void runTask(TaskState& state, int64_t now);
+};
+
+} // namespace dcs
@@ -0,0 +1,194 @@
+#pragma once
+
+#include "module.h"
+#include "shared_memory.h"
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+namespace dcs {
+
+// Latest-value table with one seqlock-protected slot per signal.
+//
+// SignalIds are process-local, so slots are assigned by signal name through
+// a directory stored with the slots: the first publish of a name claims a
+// slot, and every process resolves its own SignalId to that slot once and
+// caches the result. Ids below capacity() hit the cache; larger ids still
+// work but look the name up on every call.
+//
+// Producers overwrite their slot instead of enqueueing, so readers always see
+// the freshest sample and nothing is ever dropped. Readers never block a
+// writer: tryRead() is a single wait-free attempt, read() retries while a
+// write is in flight. The table can live in the shared memory segment so
+// loops in other processes read the same slots.
+//
+// Every publish also bumps a board-wide update counter that doubles as a
+// futex word, so event-driven consumers (in any process) can sleep until
+// something new arrives. Waits are keyed by slot: a publish makes the wake-up
+// syscall only while someone waits on its signal, and wakes only waiters
+// whose signals share its futex bit.
+class SensorBoard {
+public:
+    static constexpr const char* REGION_NAME = "sensor_board";
+
+    // Process-local board
+    explicit SensorBoard(size_t capacity);
+
+    // Board in the shared memory segment; attaches if it already exists
+    SensorBoard(SharedMemory& shm, size_t capacity);
+
+    ~SensorBoard();
+
+    SensorBoard(const SensorBoard&) = delete;
+    SensorBoard& operator=(const SensorBoard&) = delete;
+
+    static constexpr size_t MAX_SIGNAL_NAME = 59;
+
+    static size_t bytesFor(size_t capacity) {
+        return sizeof(Header) + capacity * (sizeof(Slot) + sizeof(DirectoryEntry));
+    }
+
+    // Distinct signals the board can hold
+    size_t capacity() const { return capacity_; }
+
+    // Overwrite the slot for data.id; returns false if the board is full, the
+    // id is not interned or its name is longer than MAX_SIGNAL_NAME
+    bool publish(const SensorData& data) {
+        uint32_t index = slotFor(data.id, true);
+        if (index == NO_SLOT) {
+            return false;
+        }
+        Slot& slot = slots_[index];
+        uint64_t seq = slot.sequence.load(std::memory_order_relaxed);
+        // Odd sequence = write in progress; CAS keeps concurrent writers of one signal safe
+        while ((seq & 1) || !slot.sequence.compare_exchange_weak(seq, seq + 1, std::memory_order_relaxed)) {
+            cpuRelax();
+            seq = slot.sequence.load(std::memory_order_relaxed);
+        }
+        std::atomic_thread_fence(std::memory_order_release);
+
+        uint64_t words[WORDS];
+        std::memcpy(words, &data, sizeof(SensorData));
+        for (size_t i = 0; i < WORDS; ++i) {
+            slot.words[i].store(words[i], std::memory_order_relaxed);
+        }
+        slot.sequence.store(seq + 2, std::memory_order_release);
+
+        // seq_cst pairs with waitForUpdate(): either we see its waiter or it sees our update
+        header_->updates.fetch_add(1, std::memory_order_seq_cst);
+        if (slot.waiters.load(std::memory_order_seq_cst) != 0) {
+            wakeWaiters(index);
+        }
+        return true;
+    }
+
+    // Single read attempt; false if the slot is empty or a write raced with it.
+    // out.id is set to id, whichever process published the sample.
+    bool tryRead(SignalId id, SensorData& out) const {
+        uint32_t index = slotFor(id, false);
+        if (index == NO_SLOT) {
+            return false;
+        }
+        const Slot& slot = slots_[index];
+        uint64_t before = slot.sequence.load(std::memory_order_acquire);
+        if (before == 0 || (before & 1)) {
+            return false;
+        }
+        uint64_t words[WORDS];
+        for (size_t i = 0; i < WORDS; ++i) {
+            words[i] = slot.words[i].load(std::memory_order_relaxed);
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.sequence.load(std::memory_order_relaxed) != before) {
+            return false;
+        }
+        std::memcpy(&out, words, sizeof(SensorData));
+        out.id = id;
+        return true;
+    }
+
+    // Latest sample for id; false only if it was never published
+    bool read(SignalId id, SensorData& out) const {
+        while (!tryRead(id, out)) {
+            if (version(id) == 0) {
+                return false;
+            }
+            cpuRelax();
+        }
+        return true;
+    }
+
+    // Number of completed publishes for id, lets a loop tell whether a sample is new
+    uint64_t version(SignalId id) const {
+        uint32_t index = slotFor(id, false);
+        return index != NO_SLOT ? slots_[index].sequence.load(std::memory_order_acquire) / 2 : 0;
+    }
+    
+    // Publishes to any signal so far (wraps); read it, check the slots you
+    // care about, then pass it to waitForUpdate() so no publish is missed
+    uint32_t updateCount() const { return header_->updates.load(std::memory_order_seq_cst); }
+    
+    // Sleep until one of ids is published after updateCount() returned seen,
+    // or until deadlineNs (CLOCK_MONOTONIC, as WaitStrategy::nowNs()); false
+    // on timeout. Publishes to other signals may cut the sleep short but never
+    // start it, so re-check the slots either way.
+    bool waitForUpdate(const std::vector<SignalId>& ids, uint32_t seen, int64_t deadlineNs) const;
+
+private:
+    static constexpr size_t WORDS = (sizeof(SensorData) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+    struct alignas(CACHE_LINE_SIZE) Header {
+        uint64_t capacity;
+        std::atomic<uint32_t> updates;  // Futex word
+    };
+
+    // Slots start on their own cache line so publishers of different signals never contend
+    struct alignas(CACHE_LINE_SIZE) Slot {
+        std::atomic<uint64_t> sequence;
+        std::atomic<uint64_t> words[WORDS];
+        std::atomic<uint32_t> waiters;  // On the line the publisher already writes
+    };
+
+    // Directory entry i names slot i. Entries are claimed by open addressing
+    // on the name hash and never released, so a name keeps its slot for the
+    // life of the segment.
+    struct DirectoryEntry {
+        std::atomic<uint32_t> state;    // EMPTY, CLAIMING or NAMED
+        char name[MAX_SIGNAL_NAME + 1];
+    };
+
+    static constexpr uint32_t NO_SLOT = UINT32_MAX;
+    static constexpr uint32_t UNRESOLVED = UINT32_MAX - 1;
+
+    static_assert(sizeof(DirectoryEntry) == 64, "Directory entries are 64 bytes");
+    static_assert(std::is_trivially_copyable<SensorData>::value, "SensorData must be trivially copyable");
+    static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "Futex word must be a plain 32-bit int");
+    static_assert(sizeof(Slot) % CACHE_LINE_SIZE == 0, "Sensor board slots must be whole cache lines");
+
+    Header* header_{nullptr};
+    Slot* slots_{nullptr};
+    DirectoryEntry* directory_{nullptr};
+    size_t capacity_;
+    void* localMemory_{nullptr};
+    // SignalId -> slot in this process, for ids below capacity_
+    std::unique_ptr<std::atomic<uint32_t>[]> slotCache_;
+
+    uint32_t slotFor(SignalId id, bool claim) const {
+        if (id < capacity_) {
+            uint32_t cached = slotCache_[id].load(std::memory_order_relaxed);
+            if (cached != UNRESOLVED) {
+                return cached;
+            }
+        }
+        return resolveSlot(id, claim);
+    }
+
+    uint32_t resolveSlot(SignalId id, bool claim) const;
+    void initialize(void* memory, bool create);
+    void wakeWaiters(uint32_t index) const;
+    static uint32_t futexBit(uint32_t index) { return 1u << (index % 32); }
+};
+
+} // namespace dcs
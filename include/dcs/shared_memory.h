@@ -0,0 +1,113 @@
+#pragma once
+
+#include "utils/platform.h"
+#include <string>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <stdexcept>
+
+namespace dcs {
+
+// POSIX shared memory segment shared by every module of a ControlSystem.
+//
+// The segment starts with a small directory of named regions so that any
+// process mapping it can locate queues and tables by name. Regions are
+// reserved once at setup time; everything inside the segment is addressed by
+// offsets, never by raw pointers, so mappings may differ between processes.
+class SharedMemory {
+public:
+    static constexpr size_t MAX_REGIONS = 64;
+    static constexpr size_t MAX_REGION_NAME = 47;
+
+    // Create (or open, if create is false) the segment /name of the given size
+    SharedMemory(const std::string& name, size_t size, bool create = true);
+    ~SharedMemory();
+
+    SharedMemory(const SharedMemory&) = delete;
+    SharedMemory& operator=(const SharedMemory&) = delete;
+
+    const std::string& getName() const { return name_; }
+    size_t size() const { return size_; }
+    void* data() const { return base_; }
+
+    // Bytes still available for new regions
+    size_t available() const;
+
+    // Runs on a newly reserved region before anyone else can see it
+    using RegionInit = std::function<void(void*)>;
+
+    // Return the region called regionName, reserving it if it does not exist.
+    // A new region is passed to init under the directory lock and only then
+    // published, so a concurrent reserve() or find() never returns it half
+    // built; created is set when init ran. Throws SharedMemoryException when full.
+    void* reserve(const std::string& regionName, size_t bytes,
+                  size_t alignment = CACHE_LINE_SIZE, const RegionInit& init = nullptr,
+                  bool* created = nullptr);
+
+    // Look up an existing region, nullptr if absent
+    void* find(const std::string& regionName) const;
+
+    // Offset/pointer translation for data placed inside the segment
+    uint64_t offsetOf(const void* ptr) const {
+        return static_cast<uint64_t>(static_cast<const char*>(ptr) - static_cast<const char*>(base_));
+    }
+
+    template<typename T>
+    T* at(uint64_t offset) const {
+        return reinterpret_cast<T*>(static_cast<char*>(base_) + offset);
+    }
+
+    bool contains(const void* ptr) const {
+        auto p = static_cast<const char*>(ptr);
+        auto b = static_cast<const char*>(base_);
+        return p >= b && p < b + size_;
+    }
+
+private:
+    struct Region {
+        char name[MAX_REGION_NAME + 1];
+        uint64_t offset;
+        uint64_t size;
+    };
+
+    struct Header {
+        uint64_t magic;
+        uint64_t size;
+        std::atomic<uint32_t> lock;
+        uint32_t regionCount;
+        uint64_t nextOffset;
+        Region regions[MAX_REGIONS];
+    };
+
+    std::string name_;
+    size_t size_;
+    void* base_{nullptr};
+    int fd_{-1};
+    bool owner_;
+
+    Header* header() const { return static_cast<Header*>(base_); }
+    void lockDirectory() const;
+    void unlockDirectory() const;
+    const Region* findRegion(const std::string& regionName) const;
+};
+
+// Position-independent pointer into a SharedMemory segment: an offset from the
+// segment base, valid in every process that maps the segment. Offset 0 is the
+// segment header, so it doubles as null.
+template<typename T>
+struct OffsetPtr {
+    uint64_t offset{0};
+
+    T* get(const SharedMemory& shm) const { return offset ? shm.at<T>(offset) : nullptr; }
+    explicit operator bool() const { return offset != 0; }
+    bool operator==(const OffsetPtr& other) const { return offset == other.offset; }
+    bool operator!=(const OffsetPtr& other) const { return offset != other.offset; }
+};
+
+class SharedMemoryException : public std::runtime_error {
+public:
+    explicit SharedMemoryException(const std::string& msg) : std::runtime_error(msg) {}
+};
+
+} // namespace dcs
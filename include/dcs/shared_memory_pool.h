@@ -0,0 +1,117 @@
+#pragma once
+
+#include "shared_memory.h"
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+namespace dcs {
+
+// Lock-free size-class allocator running inside a SharedMemory region.
+//
+// Blocks come in 41 classes from 128 B to 128 MB, two per power of two (2^k
+// and 1.5 * 2^k), so a request wastes at most a third of its block. Each
+// block starts with a cache-line header, so payloads are cache-line aligned.
+// Fresh blocks are carved off the region with a bump cursor; freed blocks go
+// onto a per-class Treiber stack whose head carries an ABA tag, and are never
+// split or coalesced. All bookkeeping lives in the region and is addressed by
+// offsets, so any process mapping the segment can allocate and free.
+//
+// Every allocation is tagged with an owner (for example one per module);
+// releaseOwner() returns all of an owner's blocks in one pass over the block
+// headers, without the owner having to track what it allocated.
+class SharedMemoryPool {
+public:
+    static constexpr uint32_t FREE_OWNER = 0;
+    static constexpr uint32_t SHARED_OWNER = 1;     // Default owner tag
+    static constexpr size_t HEADER_SIZE = CACHE_LINE_SIZE;
+    static constexpr size_t MIN_BLOCK_BITS = 7;
+    static constexpr size_t MAX_BLOCK_BITS = 27;
+    static constexpr size_t CLASS_COUNT = 2 * (MAX_BLOCK_BITS - MIN_BLOCK_BITS) + 1;
+
+    // Pool in region "pool:<name>" of shm; attaches if it already exists
+    SharedMemoryPool(SharedMemory& shm, size_t bytes, const std::string& name = "default");
+
+    SharedMemoryPool(const SharedMemoryPool&) = delete;
+    SharedMemoryPool& operator=(const SharedMemoryPool&) = delete;
+
+    // nullptr when the request exceeds the largest class or the region is
+    // exhausted. owner must not be FREE_OWNER.
+    void* allocate(size_t bytes, uint32_t owner = SHARED_OWNER);
+
+    // Return one block; a block already released by releaseOwner() is ignored.
+    // Throws SharedMemoryException for pointers this pool did not hand out.
+    void deallocate(void* ptr);
+
+    // Bulk free: return every live block tagged with owner, e.g. when the
+    // module that owns them unloads. Returns how many blocks were freed.
+    // Stops at a block whose header stays unpublished for 10 ms (its carver
+    // died mid-carve); blocks carved after it are not visited.
+    size_t releaseOwner(uint32_t owner);
+
+    template<typename T>
+    OffsetPtr<T> toOffset(const T* ptr) const { return {ptr ? shm_.offsetOf(ptr) : 0}; }
+
+    template<typename T>
+    T* resolve(OffsetPtr<T> ptr) const { return ptr.get(shm_); }
+
+    SharedMemory& memory() const { return shm_; }
+    size_t capacity() const { return capacity_; }
+    uint64_t carvedBytes() const;   // High-water mark of the bump cursor
+
+    // Usable bytes of the block behind ptr (at least what was requested)
+    static size_t usableSize(const void* ptr);
+    static uint32_t ownerOf(const void* ptr);
+
+    // Smallest class whose block holds bytes plus the header; CLASS_COUNT if none
+    static size_t sizeClassFor(size_t bytes);
+    static size_t blockSize(size_t sizeClass) {
+        return sizeClass & 1 ? size_t{3} << (MIN_BLOCK_BITS - 1 + sizeClass / 2)
+                             : size_t{1} << (MIN_BLOCK_BITS + sizeClass / 2);
+    }
+
+private:
+    struct alignas(CACHE_LINE_SIZE) BlockHeader {
+        std::atomic<uint64_t> next;     // Free-list link: block index + 1, 0 = end
+        std::atomic<uint32_t> owner;    // FREE_OWNER while on a free list
+        std::atomic<uint32_t> magic;    // Published last when a block is carved
+        uint32_t sizeClass;
+    };
+
+    struct alignas(CACHE_LINE_SIZE) FreeList {
+        std::atomic<uint64_t> head;     // ABA tag << 32 | (block index + 1)
+    };
+
+    struct alignas(CACHE_LINE_SIZE) PoolHeader {
+        uint64_t magic;
+        uint64_t capacity;
+        uint32_t blockMagic;
+        alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> cursor;
+        FreeList freeLists[CLASS_COUNT];
+    };
+
+    static_assert(sizeof(BlockHeader) == HEADER_SIZE, "Block header must be one cache line");
+
+    SharedMemory& shm_;
+    PoolHeader* header_{nullptr};
+    char* blocks_{nullptr};     // Block index i lives at blocks_ + i * CACHE_LINE_SIZE
+    size_t capacity_{0};
+    uint32_t blockMagic_{0};
+
+    BlockHeader* blockAt(uint64_t index) const {
+        return reinterpret_cast<BlockHeader*>(blocks_ + index * CACHE_LINE_SIZE);
+    }
+    uint64_t indexOf(const BlockHeader* block) const {
+        return static_cast<uint64_t>(reinterpret_cast<const char*>(block) - blocks_) / CACHE_LINE_SIZE;
+    }
+    static BlockHeader* headerOf(const void* ptr) {
+        return reinterpret_cast<BlockHeader*>(const_cast<char*>(static_cast<const char*>(ptr)) - HEADER_SIZE);
+    }
+
+    BlockHeader* pop(size_t sizeClass);
+    void push(BlockHeader* block);
+    BlockHeader* carve(size_t sizeClass, uint32_t owner);
+    bool awaitPublished(const BlockHeader* block) const;   // False once the wait runs out
+};
+
+} // namespace dcs
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+
+namespace dcs {
+
+// Dense integer handle for a named signal (sensor channel or actuator target)
+using SignalId = uint32_t;
+constexpr SignalId INVALID_SIGNAL = std::numeric_limits<SignalId>::max();
+
+// Process-wide name <-> SignalId table.
+//
+// Names are interned once at setup time (module initialization, loop wiring)
+// and the resulting handles are used on the hot path. Ids are dense, start at
+// zero and are never reused, so they can index flat per-signal arrays.
+class SignalRegistry {
+public:
+    static SignalRegistry& instance();
+
+    // Return the id for name, assigning the next free one on first use
+    SignalId intern(const std::string& name);
+
+    // Id for an already interned name, INVALID_SIGNAL otherwise
+    SignalId find(const std::string& name) const;
+
+    // Name of an interned id; throws std::out_of_range for unknown ids
+    const std::string& name(SignalId id) const;
+
+    size_t size() const;
+
+private:
+    SignalRegistry() = default;
+
+    mutable std::shared_mutex mutex_;
+    std::unordered_map<std::string, SignalId> ids_;
+    std::deque<std::string> names_; // deque keeps references stable on growth
+};
+
+} // namespace dcs
@@ -0,0 +1,119 @@
+#pragma once
+
+#include "platform.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ratio>
+#include <type_traits>
+
+namespace dcs {
+
+// Nanosecond clock read from the invariant time-stamp counter.
+//
+// Meets the Clock requirements and shares steady_clock's time_point. A read is
+// one rdtsc plus a fixed-point multiply, scaled by a multiplier calibrated
+// against steady_clock on first use; that takes about 20 ms, so touch the
+// clock during setup. About once a second the first read past the period
+// re-measures the rate against steady_clock over the whole run so far and
+// slews (by at most 500 ppm, never stepping) toward it, so TscClock stays
+// within microseconds of steady_clock::now(). Mixing stamps from the two is
+// fine at that granularity; intervals that must be exact to the nanosecond
+// should be taken on one clock. When the TSC is not trustworthy (no invariant
+// TSC, the kernel is not using it as its clocksource, or calibration is
+// implausible) every call forwards to steady_clock instead.
+class TscClock {
+public:
+    using duration = std::chrono::steady_clock::duration;
+    using rep = duration::rep;
+    using period = duration::period;
+    using time_point = std::chrono::steady_clock::time_point;
+    static constexpr bool is_steady = true;
+
+    static_assert(std::is_same<period, std::nano>::value, "TscClock assumes a nanosecond steady_clock");
+
+    static time_point now() noexcept {
+#if defined(__x86_64__)
+        Calibration& cal = calibration();
+        if (cal.useTsc) {
+            __extension__ typedef __int128 Wide;
+            uint64_t tsc = __rdtsc();
+            for (;;) {
+                // Seqlock: the three fields change together when the clock slews
+                uint32_t sequence = cal.sequence.load(std::memory_order_acquire);
+                uint64_t baseTicks = cal.baseTicks.load(std::memory_order_relaxed);
+                rep baseNs = cal.baseNs.load(std::memory_order_relaxed);
+                uint64_t multiplier = cal.multiplier.load(std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if ((sequence & 1) || cal.sequence.load(std::memory_order_relaxed) != sequence) {
+                    cpuRelax();
+                    continue;
+                }
+                // Signed so a read on a core a few ticks behind the base stays sane
+                auto ticks = static_cast<int64_t>(tsc - baseTicks);
+                if (ticks > cal.periodTicks) {
+                    recalibrate(cal);
+                }
+                auto ns = static_cast<rep>((static_cast<Wide>(ticks) * static_cast<Wide>(multiplier)) >> SHIFT);
+                return time_point(duration(baseNs + ns));
+            }
+        }
+#endif
+        return std::chrono::steady_clock::now();
+    }
+
+    // True if now() reads the TSC, false if it falls back to steady_clock
+    static bool usingTsc() { return calibration().useTsc; }
+
+    // Measured TSC frequency, 0 when falling back
+    static double ticksPerSecond() { return calibration().ticksPerSecond.load(std::memory_order_relaxed); }
+
+private:
+    static constexpr unsigned SHIFT = 32;
+
+    struct Calibration {
+        bool useTsc{false};
+        int64_t periodTicks{0};         // Slew again once the base is this old
+        uint64_t originTicks{0};        // First calibration point, the rate's baseline
+        int64_t originNs{0};
+        std::atomic<uint32_t> sequence{0};
+        std::atomic<uint64_t> baseTicks{0};
+        std::atomic<rep> baseNs{0};
+        std::atomic<uint64_t> multiplier{0};    // Nanoseconds per tick, 32.32 fixed point
+        std::atomic<double> ticksPerSecond{0.0};
+        std::atomic<bool> recalibrating{false};
+    };
+
+    static Calibration& calibration() {
+        static Calibration cal;
+        static const bool calibrated = (calibrate(cal), true);
+        (void)calibrated;
+        return cal;
+    }
+
+    static void calibrate(Calibration& cal);
+    static void recalibrate(Calibration& cal) noexcept;     // One thread at a time, others skip
+};
+
+// Clock that only moves when told to. Replay runs control loops on one so a
+// recording plays back as fast as the loops can cycle while they see the
+// timestamps they saw when it was captured. Shares TscClock's time_point.
+class VirtualClock {
+public:
+    using duration = TscClock::duration;
+    using time_point = TscClock::time_point;
+
+    time_point now() const noexcept { return time_point(duration(ns_.load(std::memory_order_acquire))); }
+    void set(time_point t) noexcept { ns_.store(t.time_since_epoch().count(), std::memory_order_release); }
+    void advance(duration d) noexcept { ns_.fetch_add(d.count(), std::memory_order_acq_rel); }
+
+private:
+    std::atomic<duration::rep> ns_{0};
+};
+
+// Nanoseconds elapsed since start on TscClock
+inline uint64_t elapsedNs(TscClock::time_point start) {
+    return static_cast<uint64_t>((TscClock::now() - start).count());
+}
+
+} // namespace dcs
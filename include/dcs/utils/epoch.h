@@ -0,0 +1,79 @@
+#pragma once
+
+#include "platform.h"
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+namespace dcs {
+
+// Process-wide epoch-based reclamation (a lightweight userspace RCU).
+//
+// Readers bracket hot-path access to shared objects with an EpochGuard, which
+// publishes the current epoch in a per-thread cache-line slot. Writers unlink
+// an object, then retire() it; the deleter runs only once every reader that
+// could still hold a reference has left its critical section. synchronize()
+// blocks for a full grace period, for teardown that cannot be deferred.
+class EpochDomain {
+public:
+    static constexpr size_t MAX_THREADS = 256;
+
+    static EpochDomain& instance();
+
+    // Reader side; nests, cost is one store and one fence on entry
+    void enter();
+    void exit();
+    // The calling thread is inside an EpochGuard (synchronize() would deadlock)
+    bool inReadSection();
+
+    // Defer deleter until no reader can still observe the retired object
+    void retire(std::function<void()> deleter);
+
+    // Run deleters whose grace period has elapsed; returns how many ran
+    size_t reclaim();
+
+    // Block until every reader active at the time of the call has exited
+    void synchronize();
+
+    size_t pendingCount() const;
+
+private:
+    EpochDomain() = default;
+
+    struct alignas(CACHE_LINE_SIZE) ReaderSlot {
+        std::atomic<uint64_t> epoch{0};     // 0 = quiescent
+        std::atomic<bool> claimed{false};
+    };
+
+    struct Retired {
+        uint64_t epoch;
+        std::function<void()> deleter;
+    };
+
+    struct ThreadState;
+
+    std::atomic<uint64_t> globalEpoch_{1};
+    ReaderSlot slots_[MAX_THREADS];
+
+    mutable std::mutex retiredMutex_;
+    std::vector<Retired> retired_;
+
+    ThreadState& threadState();
+    uint64_t oldestActiveEpoch() const;
+
+    friend struct ThreadState;
+};
+
+// RAII read-side critical section on the process-wide epoch domain
+class EpochGuard {
+public:
+    EpochGuard() { EpochDomain::instance().enter(); }
+    ~EpochGuard() { EpochDomain::instance().exit(); }
+
+    EpochGuard(const EpochGuard&) = delete;
+    EpochGuard& operator=(const EpochGuard&) = delete;
+};
+
+} // namespace dcs
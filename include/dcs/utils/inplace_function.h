@@ -0,0 +1,153 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace dcs {
+
+template<typename Signature, size_t Capacity = 48>
+class InplaceFunction;
+
+// std::function replacement that never allocates.
+//
+// The callable is stored by value in a fixed in-object buffer; one that does
+// not fit is a compile error rather than a hidden heap allocation, so
+// capture large state by reference or pointer. A call is one indirect jump
+// into a thunk instantiated for the concrete type, with the callable's body
+// inlined there. With the default capacity the whole object is one cache line.
+template<typename R, typename... Args, size_t Capacity>
+class InplaceFunction<R(Args...), Capacity> {
+public:
+    template<typename F>
+    static constexpr bool fits() {
+        return sizeof(F) <= Capacity && alignof(F) <= alignof(std::max_align_t) &&
+               std::is_nothrow_move_constructible<F>::value;
+    }
+
+    InplaceFunction() = default;
+    InplaceFunction(std::nullptr_t) {}
+
+    template<typename F, typename Fn = std::decay_t<F>,
+             typename = std::enable_if_t<!std::is_same<Fn, InplaceFunction>::value &&
+                                         std::is_invocable_r<R, Fn&, Args...>::value>>
+    InplaceFunction(F&& f) {
+        static_assert(fits<Fn>(), "Callable does not fit InplaceFunction; capture large state by reference");
+        static_assert(std::is_copy_constructible<Fn>::value, "InplaceFunction needs a copyable callable");
+        if (isEmpty(f)) {
+            return;
+        }
+        ::new (static_cast<void*>(storage_)) Fn(std::forward<F>(f));
+        invoke_ = &invokeTarget<Fn>;
+        manage_ = &manageTarget<Fn>;
+    }
+
+    InplaceFunction(const InplaceFunction& other) : invoke_(other.invoke_), manage_(other.manage_) {
+        if (manage_) {
+            manage_(Op::COPY, storage_, other.storage_);
+        }
+    }
+
+    InplaceFunction(InplaceFunction&& other) noexcept : invoke_(other.invoke_), manage_(other.manage_) {
+        if (manage_) {
+            manage_(Op::MOVE, storage_, other.storage_);
+            other.reset();
+        }
+    }
+
+    ~InplaceFunction() { reset(); }
+
+    InplaceFunction& operator=(const InplaceFunction& other) {
+        if (this != &other) {
+            InplaceFunction copy(other);
+            *this = std::move(copy);
+        }
+        return *this;
+    }
+
+    InplaceFunction& operator=(InplaceFunction&& other) noexcept {
+        if (this != &other) {
+            reset();
+            if (other.manage_) {
+                other.manage_(Op::MOVE, storage_, other.storage_);
+                invoke_ = other.invoke_;
+                manage_ = other.manage_;
+                other.reset();
+            }
+        }
+        return *this;
+    }
+
+    InplaceFunction& operator=(std::nullptr_t) {
+        reset();
+        return *this;
+    }
+
+    explicit operator bool() const { return manage_ != nullptr; }
+
+    // Like std::function, calling an empty function throws std::bad_function_call
+    R operator()(Args... args) const {
+        return invoke_(storage_, std::forward<Args>(args)...);
+    }
+
+private:
+    enum class Op { COPY, MOVE, DESTROY };
+
+    using Invoke = R (*)(void* target, Args&&... args);
+    using Manage = void (*)(Op op, void* dst, void* src);
+
+    // Empty std::function objects and null function pointers stay empty
+    template<typename Fn>
+    static bool isEmpty(const Fn& f) {
+        if constexpr (std::is_pointer<Fn>::value || std::is_member_pointer<Fn>::value) {
+            return f == nullptr;
+        } else {
+            return isEmptyFunction(f);
+        }
+    }
+
+    template<typename Sig>
+    static bool isEmptyFunction(const std::function<Sig>& f) { return !f; }
+    template<typename Fn>
+    static bool isEmptyFunction(const Fn&) { return false; }
+
+    template<typename Fn>
+    static R invokeTarget(void* target, Args&&... args) {
+        return std::invoke(*static_cast<Fn*>(target), std::forward<Args>(args)...);
+    }
+
+    static R invokeEmpty(void*, Args&&...) {
+        throw std::bad_function_call();
+    }
+
+    template<typename Fn>
+    static void manageTarget(Op op, void* dst, void* src) {
+        switch (op) {
+            case Op::COPY:
+                ::new (dst) Fn(*static_cast<const Fn*>(src));
+                break;
+            case Op::MOVE:
+                ::new (dst) Fn(std::move(*static_cast<Fn*>(src)));
+                break;
+            case Op::DESTROY:
+                static_cast<Fn*>(dst)->~Fn();
+                break;
+        }
+    }
+
+    void reset() {
+        if (manage_) {
+            manage_(Op::DESTROY, storage_, nullptr);
+        }
+        invoke_ = &invokeEmpty;
+        manage_ = nullptr;
+    }
+
+    alignas(std::max_align_t) mutable unsigned char storage_[Capacity];
+    Invoke invoke_{&invokeEmpty};     // Never null, so a call needs no emptiness check
+    Manage manage_{nullptr};
+};
+
+} // namespace dcs
@@ -0,0 +1,176 @@
+#pragma once
+
+#include "platform.h"
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <sched.h>
+
+namespace dcs {
+
+// Percentile summary of a latency distribution, all values in nanoseconds
+struct LatencySummary {
+    uint64_t count{0};
+    uint64_t min{0};
+    double mean{0.0};
+    uint64_t p50{0};
+    uint64_t p90{0};
+    uint64_t p99{0};
+    uint64_t p999{0};
+    uint64_t max{0};
+};
+
+// Fixed-memory, lock-free HDR-style latency histogram.
+//
+// Values (nanoseconds) land in log-linear buckets: exact below 64 ns, then 32
+// sub-buckets per power of two, which bounds the relative error of any
+// reported percentile to about 3%. Values above ~18 minutes are clamped into
+// the last bucket. Recording is a handful of relaxed atomic increments, any
+// number of threads may record concurrently, and histograms merge by adding
+// bucket counts.
+class LatencyHistogram {
+public:
+    static constexpr unsigned SUB_BUCKET_BITS = 6;
+    static constexpr uint64_t SUB_BUCKET_COUNT = 1ULL << SUB_BUCKET_BITS;
+    static constexpr uint64_t SUB_BUCKET_HALF = SUB_BUCKET_COUNT / 2;
+    static constexpr unsigned MAX_VALUE_BITS = 40;
+    static constexpr uint64_t MAX_VALUE = (1ULL << MAX_VALUE_BITS) - 1;
+    static constexpr size_t BUCKET_COUNT =
+        SUB_BUCKET_COUNT + (MAX_VALUE_BITS - SUB_BUCKET_BITS) * SUB_BUCKET_HALF;
+
+    LatencyHistogram() { reset(); }
+
+    LatencyHistogram(const LatencyHistogram&) = delete;
+    LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+
+    void record(uint64_t valueNs) {
+        if (valueNs > MAX_VALUE) {
+            valueNs = MAX_VALUE;
+        }
+        counts_[bucketIndex(valueNs)].fetch_add(1, std::memory_order_relaxed);
+        totalCount_.fetch_add(1, std::memory_order_relaxed);
+        sum_.fetch_add(valueNs, std::memory_order_relaxed);
+        updateMin(valueNs);
+        updateMax(valueNs);
+    }
+
+    // Add other's samples to this histogram (other may still be recording)
+    void merge(const LatencyHistogram& other);
+    void reset();
+
+    uint64_t count() const { return totalCount_.load(std::memory_order_relaxed); }
+    uint64_t max() const { return max_.load(std::memory_order_relaxed); }
+
+    // Value at or below which the given percentile (0-100) of samples fall
+    uint64_t percentile(double p) const;
+    LatencySummary summary() const;
+
+    static size_t bucketIndex(uint64_t value) {
+        if (value < SUB_BUCKET_COUNT) {
+            return static_cast<size_t>(value);
+        }
+        unsigned msb = 63 - static_cast<unsigned>(__builtin_clzll(value));
+        unsigned shift = msb - SUB_BUCKET_BITS + 1;
+        return static_cast<size_t>(SUB_BUCKET_COUNT + (shift - 1) * SUB_BUCKET_HALF +
+                                   ((value >> shift) - SUB_BUCKET_HALF));
+    }
+
+    // Largest value that maps to the given bucket
+    static uint64_t bucketUpperBound(size_t index) {
+        if (index < SUB_BUCKET_COUNT) {
+            return index;
+        }
+        uint64_t k = index - SUB_BUCKET_COUNT;
+        uint64_t shift = k / SUB_BUCKET_HALF + 1;
+        uint64_t sub = k % SUB_BUCKET_HALF + SUB_BUCKET_HALF;
+        return (sub << shift) + (1ULL << shift) - 1;
+    }
+
+private:
+    alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> totalCount_;
+    std::atomic<uint64_t> sum_;
+    std::atomic<uint64_t> min_;
+    std::atomic<uint64_t> max_;
+    std::array<std::atomic<uint64_t>, BUCKET_COUNT> counts_;
+
+    void updateMin(uint64_t value) {
+        uint64_t current = min_.load(std::memory_order_relaxed);
+        while (value < current &&
+               !min_.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+        }
+    }
+
+    void updateMax(uint64_t value) {
+        uint64_t current = max_.load(std::memory_order_relaxed);
+        while (value > current &&
+               !max_.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+        }
+    }
+};
+
+// LatencyHistogram split into cache-line aligned per-CPU shards.
+//
+// A record lands in the shard of the CPU it runs on (sched_getcpu(), served
+// from the vDSO/rseq area), so recorders on different cores never share a
+// counter and two threads only meet in one shard when the scheduler moves
+// one of them mid-record. Shards are allocated on first use, so a histogram
+// costs memory only for the CPUs that actually record into it. Recording is
+// wait-free apart from the min/max CAS.
+//
+// Reads merge the shards lazily. Begin/end counters per shard act as a
+// seqlock: a shard copied while a record was in flight is copied again, for
+// up to a millisecond, so a recorder preempted mid-record gets to finish.
+// Only a shard recorded into back to back for that whole time is taken as
+// is, and then each sample still in flight may be partly counted (e.g. in
+// count but not yet in max). Recorders never wait for readers.
+class ShardedLatencyHistogram {
+public:
+    ShardedLatencyHistogram();
+    ~ShardedLatencyHistogram();
+    ShardedLatencyHistogram(const ShardedLatencyHistogram&) = delete;
+    ShardedLatencyHistogram& operator=(const ShardedLatencyHistogram&) = delete;
+
+    void record(uint64_t valueNs) {
+        Shard& shard = localShard();
+        shard.begin.fetch_add(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        shard.histogram.record(valueNs);
+        shard.end.fetch_add(1, std::memory_order_release);
+    }
+
+    void recordError() {
+        localShard().errors.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    uint64_t errorCount() const;
+
+    // Merge a snapshot of all shards into out; see the class comment
+    void snapshot(LatencyHistogram& out) const;
+    LatencySummary summary() const;
+    uint64_t percentile(double p) const;
+
+    size_t shardCount() const { return shardCount_; }
+
+private:
+    struct alignas(CACHE_LINE_SIZE) Shard {
+        std::atomic<uint64_t> begin{0};
+        std::atomic<uint64_t> end{0};
+        std::atomic<uint64_t> errors{0};
+        LatencyHistogram histogram;
+    };
+
+    size_t shardCount_;     // Configured CPUs
+    std::unique_ptr<std::atomic<Shard*>[]> shards_;
+
+    Shard& localShard() {
+        int cpu = sched_getcpu();
+        size_t index = cpu >= 0 ? static_cast<size_t>(cpu) % shardCount_ : 0;
+        Shard* shard = shards_[index].load(std::memory_order_acquire);
+        return shard ? *shard : createShard(index);
+    }
+
+    Shard& createShard(size_t index);
+};
+
+} // namespace dcs
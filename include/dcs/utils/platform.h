@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstddef>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+namespace dcs {
+
+// Destructive interference size used to pad shared atomics
+constexpr size_t CACHE_LINE_SIZE = 64;
+
+// Spin-wait hint: `pause` on x86, `yield` on ARM, no-op elsewhere
+inline void cpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+    _mm_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+    asm volatile("yield" ::: "memory");
+#endif
+}
+
+// Widest vector instruction set the CPU supports; the kernels that have
+// AVX2 and AVX-512 paths dispatch on this
+enum class SimdLevel {
+    SCALAR,
+    AVX2,
+    AVX512
+};
+
+inline SimdLevel simdLevel() {
+    static const SimdLevel level = []() {
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx512f")) {
+            return SimdLevel::AVX512;
+        }
+        if (__builtin_cpu_supports("avx2")) {
+            return SimdLevel::AVX2;
+        }
+#endif
+        return SimdLevel::SCALAR;
+    }();
+    return level;
+}
+
+} // namespace dcs
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+#include <pthread.h>
+#include <string>
+#include <vector>
+
+namespace dcs {
+
+// Best-effort real-time setup. Each call returns an empty string on success,
+// otherwise what could not be applied and why (typically a missing
+// CAP_SYS_NICE / CAP_IPC_LOCK or a low RLIMIT_MEMLOCK), so callers can carry
+// on without the guarantee instead of failing.
+
+// SCHED_FIFO at priority 1-99; 0 leaves the thread SCHED_OTHER
+std::string setThreadPriority(pthread_t thread, int priority);
+
+// Restrict the thread to cpus; an empty set leaves its affinity unchanged
+std::string setThreadAffinity(pthread_t thread, const std::vector<int>& cpus);
+
+// mlockall(MCL_CURRENT | MCL_FUTURE): no page of the process is ever swapped
+// out or faulted in lazily after this
+std::string lockProcessMemory();
+
+// Fault in every page of [data, data + bytes) without changing its contents
+void prefaultMemory(void* data, size_t bytes);
+
+// Fault in the next `bytes` of the calling thread's stack
+void prefaultStack(size_t bytes);
+
+// CPUs this process may run on, minus excluded
+std::vector<int> cpusExcluding(const std::vector<int>& excluded);
+
+} // namespace dcs
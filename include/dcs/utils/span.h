@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+
+namespace dcs {
+
+// Minimal non-owning view over contiguous elements (std::span is C++20)
+template<typename T>
+class Span {
+public:
+    using element_type = T;
+    using value_type = std::remove_cv_t<T>;
+    using iterator = T*;
+
+    constexpr Span() = default;
+    constexpr Span(T* data, size_t size) : data_(data), size_(size) {}
+
+    template<size_t N>
+    constexpr Span(T (&array)[N]) : data_(array), size_(N) {}
+
+    template<typename U, typename = std::enable_if_t<std::is_convertible<U (*)[], T (*)[]>::value>>
+    Span(std::vector<U>& vec) : data_(vec.data()), size_(vec.size()) {}
+
+    template<typename U, typename = std::enable_if_t<std::is_convertible<const U (*)[], T (*)[]>::value>>
+    Span(const std::vector<U>& vec) : data_(vec.data()), size_(vec.size()) {}
+
+    template<typename U, typename = std::enable_if_t<std::is_convertible<U (*)[], T (*)[]>::value>>
+    constexpr Span(const Span<U>& other) : data_(other.data()), size_(other.size()) {}
+
+    constexpr T* data() const { return data_; }
+    constexpr size_t size() const { return size_; }
+    constexpr bool empty() const { return size_ == 0; }
+    constexpr T& operator[](size_t i) const { return data_[i]; }
+    constexpr iterator begin() const { return data_; }
+    constexpr iterator end() const { return data_ + size_; }
+
+    constexpr Span subspan(size_t offset, size_t count) const { return Span(data_ + offset, count); }
+
+private:
+    T* data_{nullptr};
+    size_t size_{0};
+};
+
+} // namespace dcs
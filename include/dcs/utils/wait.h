@@ -0,0 +1,87 @@
+#pragma once
+
+#include "platform.h"
+#include <algorithm>
+#include <cstdint>
+#include <time.h>
+
+namespace dcs {
+
+// How a thread waits for a release time or for work to arrive
+enum class WaitMode {
+    SLEEP,              // Sleep the whole way; cheapest, pays the kernel wake-up latency
+    SPIN_THEN_SLEEP,    // Sleep until the spin budget before the deadline, then spin
+    BUSY_POLL           // Spin with cpuRelax() the whole way; owns its core
+};
+
+struct WaitOptions {
+    WaitMode mode{WaitMode::SLEEP};
+    int64_t initialSpinNs{50000};   // Spin budget until wake-ups have been measured
+    int64_t maxSpinNs{500000};      // Upper bound on the adaptive spin budget
+    int64_t sleepSliceNs{50000};    // Poll interval while a consumer sleeps
+};
+
+// Wait policy for one thread; not thread-safe, keep one per waiting thread.
+//
+// The spin budget follows the measured wake-up latency: every sleep records
+// how late the kernel woke us, the budget is a decaying peak of that plus a
+// quarter, so SPIN_THEN_SLEEP wakes early enough to spin onto the deadline
+// and burns no more CPU than the scheduler makes necessary on this core.
+// Times are CLOCK_MONOTONIC nanoseconds, the clock the sleeps run on.
+class WaitStrategy {
+public:
+    explicit WaitStrategy(const WaitOptions& options = WaitOptions{});
+
+    // Block until deadlineNs; returns how late we returned
+    int64_t waitUntil(int64_t deadlineNs);
+
+    // Poll ready() until it returns true or timeoutNs passes; SLEEP and
+    // SPIN_THEN_SLEEP check it every sleepSliceNs once their spin is spent
+    template<typename Ready>
+    bool waitFor(Ready&& ready, int64_t timeoutNs) {
+        if (ready()) {
+            return true;
+        }
+        int64_t start = nowNs();
+        int64_t deadline = start + timeoutNs;
+        int64_t spinEnd = options_.mode == WaitMode::BUSY_POLL ? deadline
+                        : options_.mode == WaitMode::SPIN_THEN_SLEEP ? std::min(deadline, start + spinBudgetNs())
+                        : start;
+        while (nowNs() < spinEnd) {
+            if (ready()) {
+                return true;
+            }
+            cpuRelax();
+        }
+        for (int64_t now = nowNs(); now < deadline; now = nowNs()) {
+            sleepUntil(std::min(deadline, now + options_.sleepSliceNs));
+            if (ready()) {
+                return true;
+            }
+        }
+        return ready();
+    }
+
+    WaitMode mode() const { return options_.mode; }
+    int64_t wakeLatencyNs() const { return wakeLatencyNs_; }
+    int64_t spinBudgetNs() const {
+        return std::min(options_.maxSpinNs, wakeLatencyNs_ + wakeLatencyNs_ / 4);
+    }
+
+    // CLOCK_MONOTONIC rather than TscClock: deadlines are handed to
+    // clock_nanosleep, and a slewed TSC would wake early or measure lateness
+    // against a different time base
+    static int64_t nowNs() {
+        timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return static_cast<int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+    }
+
+private:
+    WaitOptions options_;
+    int64_t wakeLatencyNs_;     // Decaying peak of measured sleep overshoot
+
+    void sleepUntil(int64_t targetNs);
+};
+
+} // namespace dcs
@@ -0,0 +1,152 @@
+#pragma once
+
+#include "utils/platform.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace dcs {
+
+using WatchId = uint32_t;
+constexpr WatchId INVALID_WATCH = 0xFFFFFFFFu;
+
+// Hot-path side of a watch: beat() is one relaxed load of the watchdog's tick
+// counter (a read-shared line) and one relaxed store to the watch's own line.
+// A default-constructed Heartbeat is unwatched and beat() does nothing. The
+// slot's generation, on the same line, turns a Heartbeat kept past unwatch()
+// into a no-op instead of feeding whichever watch reuses the id.
+class Heartbeat {
+public:
+    Heartbeat() = default;
+
+    void beat() const {
+        if (last_ && generation_->load(std::memory_order_relaxed) == expected_) {
+            last_->store(clock_->load(std::memory_order_relaxed), std::memory_order_relaxed);
+        }
+    }
+    bool isWatched() const { return last_ != nullptr; }
+
+private:
+    friend class Watchdog;
+    Heartbeat(const std::atomic<uint64_t>* clock, std::atomic<uint64_t>* last,
+              const std::atomic<uint32_t>* generation, uint32_t expected)
+        : clock_(clock), last_(last), generation_(generation), expected_(expected) {}
+
+    const std::atomic<uint64_t>* clock_{nullptr};
+    std::atomic<uint64_t>* last_{nullptr};
+    const std::atomic<uint32_t>* generation_{nullptr};
+    uint32_t expected_{0};
+};
+
+// Hierarchical timer-wheel watchdog.
+//
+// Every watch sits in the wheel at the tick its deadline falls due, computed
+// from its last heartbeat. Heartbeats never touch the wheel; when a slot comes
+// up the watch is either re-filed at its new deadline or reported expired, so
+// a watch costs one wheel operation per timeout period no matter how often it
+// beats, and each tick only visits the watches due in that tick. Expiry is
+// detected within one tick of the deadline.
+//
+// Four levels: 256 one-tick slots, then 3 x 64 coarser slots that cascade
+// down, covering timeouts up to 2^26 ticks (~18 h at 1 ms).
+class Watchdog {
+public:
+    // Runs on the watchdog thread, outside any lock; `missedTicks` is the time
+    // since the last heartbeat
+    using ExpiryCallback = std::function<void(WatchId id, const std::string& name, uint64_t missedTicks)>;
+
+    explicit Watchdog(std::chrono::microseconds tick = std::chrono::microseconds(1000), size_t capacity = 4096);
+    ~Watchdog();
+
+    Watchdog(const Watchdog&) = delete;
+    Watchdog& operator=(const Watchdog&) = delete;
+
+    // Start watching; the first deadline is one timeout from now. A zero
+    // timeout registers the watch disarmed, so its Heartbeat can be handed out
+    // before anyone decides on a deadline. Throws std::length_error when all
+    // `capacity` watches are in use.
+    WatchId watch(const std::string& name, std::chrono::microseconds timeout, ExpiryCallback onExpiry);
+    void unwatch(WatchId id);
+    void setTimeout(WatchId id, std::chrono::microseconds timeout);
+
+    // Handle for the hot path; beat() becomes a no-op once the watch is
+    // unwatched, even if its id is reused. Empty for an id not being watched.
+    Heartbeat heartbeat(WatchId id) const;
+    void beat(WatchId id) const { heartbeat(id).beat(); }
+
+    bool isExpired(WatchId id) const;
+    size_t watchCount() const;
+
+    // Drive the wheel from a dedicated thread, one tick per period; returns
+    // why the setCpus() placement could not be applied, if so (it still runs)
+    std::string start();
+    void stop();
+    bool isRunning() const { return running_; }
+    
+    // Keep the watchdog thread on cpus, now and on every later start(), e.g.
+    // off the real-time cores; returns why it could not be applied, if so
+    std::string setCpus(const std::vector<int>& cpus);
+
+    // Process the next tick; start() calls this, tests may call it directly
+    void advance();
+    uint64_t now() const { return now_.load(std::memory_order_relaxed); }
+    std::chrono::microseconds tickPeriod() const { return tick_; }
+
+private:
+    static constexpr uint32_t NIL = 0xFFFFFFFFu;
+    static constexpr int LEVEL0_BITS = 8;
+    static constexpr int LEVELN_BITS = 6;
+    static constexpr int LEVELS = 4;
+    static constexpr size_t SLOT_COUNT = (1u << LEVEL0_BITS) + (LEVELS - 1) * (1u << LEVELN_BITS);
+    static constexpr uint64_t MAX_TICKS = (uint64_t{1} << (LEVEL0_BITS + (LEVELS - 1) * LEVELN_BITS)) - 1;
+
+    // Written by heartbeats; one line per watch so beats never false-share.
+    // unwatch() bumps generation to retire the Heartbeats handed out so far.
+    struct alignas(CACHE_LINE_SIZE) Beat {
+        std::atomic<uint64_t> lastTick{0};
+        std::atomic<uint32_t> generation{0};
+    };
+
+    // Wheel bookkeeping, only touched under mutex_
+    struct Node {
+        std::string name;
+        ExpiryCallback onExpiry;
+        uint64_t timeout{0};
+        uint64_t due{0};
+        uint32_t slot{NIL};
+        uint32_t next{NIL};
+        uint32_t prev{NIL};
+        bool active{false};
+        bool expired{false};
+    };
+
+    std::chrono::microseconds tick_;
+    size_t capacity_;
+    std::unique_ptr<Beat[]> beats_;
+    alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> now_{0};
+
+    mutable std::mutex mutex_;
+    std::vector<Node> nodes_;
+    std::vector<uint32_t> freeList_;
+    std::vector<uint32_t> slots_;
+    size_t active_{0};
+
+    std::thread thread_;
+    std::atomic<bool> running_{false};
+    std::vector<int> cpus_;
+
+    uint64_t toTicks(std::chrono::microseconds timeout) const;
+    void schedule(uint32_t id, uint64_t due);
+    void unlink(uint32_t id);
+    void cascade(int level);
+    void checkId(WatchId id) const;
+    void run();
+};
+
+} // namespace dcs
@@ -0,0 +1,210 @@
+#include <dcs/module.h>
+#include <chrono>
+#include <limits>
+#include <unordered_map>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define DCS_BATCH_X86 1
+#endif
+
+namespace dcs {
+
+namespace {
+
+struct GroupLimits {
+    double minValue;
+    double maxValue;
+    double step;        // Largest change per channel this batch
+};
+
+// Reference per-channel rule; max/min are written the way the vector
+// instructions evaluate them so every path gives identical results
+void limitScalar(double* values, double* last, uint64_t* clampedBits, size_t begin, size_t end,
+                 const GroupLimits& limits) {
+    for (size_t i = begin; i < end; ++i) {
+        double requested = values[i];
+        double v = requested != requested ? last[i] : requested;
+        double lo = last[i] - limits.step;
+        double hi = last[i] + limits.step;
+        v = v > lo ? v : lo;
+        v = v < hi ? v : hi;
+        v = v > limits.minValue ? v : limits.minValue;
+        v = v < limits.maxValue ? v : limits.maxValue;
+        if (!(v == requested)) {
+            clampedBits[i / 64] |= uint64_t(1) << (i % 64);
+        }
+        values[i] = v;
+        last[i] = v;
+    }
+}
+
+#ifdef DCS_BATCH_X86
+
+// Returns the first index left for the scalar tail
+__attribute__((target("avx2"))) size_t limitAvx2(double* values, double* last, uint64_t* clampedBits,
+                                                 size_t count, const GroupLimits& limits) {
+    const __m256d step = _mm256_set1_pd(limits.step);
+    const __m256d minValue = _mm256_set1_pd(limits.minValue);
+    const __m256d maxValue = _mm256_set1_pd(limits.maxValue);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m256d requested = _mm256_loadu_pd(values + i);
+        __m256d previous = _mm256_loadu_pd(last + i);
+        __m256d v = _mm256_blendv_pd(requested, previous, _mm256_cmp_pd(requested, requested, _CMP_UNORD_Q));
+        v = _mm256_max_pd(v, _mm256_sub_pd(previous, step));
+        v = _mm256_min_pd(v, _mm256_add_pd(previous, step));
+        v = _mm256_max_pd(v, minValue);
+        v = _mm256_min_pd(v, maxValue);
+        uint64_t changed = static_cast<uint64_t>(_mm256_movemask_pd(_mm256_cmp_pd(v, requested, _CMP_NEQ_UQ)));
+        clampedBits[i / 64] |= changed << (i % 64);
+        _mm256_storeu_pd(values + i, v);
+        _mm256_storeu_pd(last + i, v);
+    }
+    return i;
+}
+
+// a > b ? a : b, like maxpd; _mm512_max_pd trips a GCC 12 uninitialized warning
+__attribute__((target("avx512f"))) inline __m512d max8(__m512d a, __m512d b) {
+    return _mm512_mask_blend_pd(_mm512_cmp_pd_mask(a, b, _CMP_GT_OQ), b, a);
+}
+
+__attribute__((target("avx512f"))) inline __m512d min8(__m512d a, __m512d b) {
+    return _mm512_mask_blend_pd(_mm512_cmp_pd_mask(a, b, _CMP_LT_OQ), b, a);
+}
+
+__attribute__((target("avx512f"))) size_t limitAvx512(double* values, double* last, uint64_t* clampedBits,
+                                                      size_t count, const GroupLimits& limits) {
+    const __m512d step = _mm512_set1_pd(limits.step);
+    const __m512d minValue = _mm512_set1_pd(limits.minValue);
+    const __m512d maxValue = _mm512_set1_pd(limits.maxValue);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m512d requested = _mm512_loadu_pd(values + i);
+        __m512d previous = _mm512_loadu_pd(last + i);
+        __m512d v = _mm512_mask_blend_pd(_mm512_cmp_pd_mask(requested, requested, _CMP_UNORD_Q), requested, previous);
+        v = max8(v, _mm512_sub_pd(previous, step));
+        v = min8(v, _mm512_add_pd(previous, step));
+        v = max8(v, minValue);
+        v = min8(v, maxValue);
+        uint64_t changed = _mm512_cmp_pd_mask(v, requested, _CMP_NEQ_UQ);
+        clampedBits[i / 64] |= changed << (i % 64);
+        _mm512_storeu_pd(values + i, v);
+        _mm512_storeu_pd(last + i, v);
+    }
+    return i;
+}
+
+#endif // DCS_BATCH_X86
+
+} // namespace
+
+Span<const uint32_t> ActuatorModule::executeBatch(Span<const ActuatorCommand> commands) {
+    auto now = TscClock::now();
+    double dt = batch_.lastBatch == TscClock::time_point{}
+        ? std::numeric_limits<double>::infinity()
+        : std::chrono::duration<double>(now - batch_.lastBatch).count();
+    batch_.lastBatch = now;
+    return executeBatch(commands, dt);
+}
+
+Span<const uint32_t> ActuatorModule::executeBatch(Span<const ActuatorCommand> commands, double dt) {
+    const size_t count = commands.size();
+    batch_.clamped.clear();
+    if (isEmergencyStopped()) {
+        return Span<const uint32_t>(batch_.clamped);
+    }
+
+    GroupLimits limits{limits_.minValue, limits_.maxValue, limits_.maxRate * dt};
+    if (!(limits.step >= 0.0)) {
+        limits.step = std::numeric_limits<double>::infinity();   // dt unknown (NaN)
+    }
+    remapHistory(commands);
+
+    batch_.values.resize(count);
+    batch_.clampedBits.assign((count + 63) / 64, 0);
+    for (size_t i = 0; i < count; ++i) {
+        batch_.values[i] = commands[i].value;
+    }
+
+    double* values = batch_.values.data();
+    double* last = batch_.lastApplied.data();
+    uint64_t* bits = batch_.clampedBits.data();
+    size_t done = 0;
+#ifdef DCS_BATCH_X86
+    switch (simdLevel()) {
+        case SimdLevel::AVX512:
+            done = limitAvx512(values, last, bits, count, limits);
+            break;
+        case SimdLevel::AVX2:
+            done = limitAvx2(values, last, bits, count, limits);
+            break;
+        case SimdLevel::SCALAR:
+            break;
+    }
+#endif
+    limitScalar(values, last, bits, done, count, limits);
+
+    // Channels that were not in the previous batch have no history to
+    // rate-limit against: redo them with the hard limits only
+    GroupLimits fresh = limits;
+    fresh.step = std::numeric_limits<double>::infinity();
+    for (uint32_t i : batch_.fresh) {
+        values[i] = commands[i].value;
+        last[i] = 0.0;
+        bits[i / 64] &= ~(uint64_t(1) << (i % 64));
+        limitScalar(values, last, bits, i, i + 1, fresh);
+    }
+
+    batch_.limited.assign(commands.begin(), commands.end());
+    for (size_t i = 0; i < count; ++i) {
+        batch_.limited[i].value = values[i];
+    }
+    for (size_t word = 0; word < batch_.clampedBits.size(); ++word) {
+        for (uint64_t w = batch_.clampedBits[word]; w != 0; w &= w - 1) {
+            batch_.clamped.push_back(static_cast<uint32_t>(word * 64 + static_cast<size_t>(__builtin_ctzll(w))));
+        }
+    }
+
+    applyBatch(Span<const ActuatorCommand>(batch_.limited));
+    return Span<const uint32_t>(batch_.clamped);
+}
+
+// Line lastApplied up with this batch's channels by command id. The same
+// channels in the same order, the steady case, cost one compare each.
+void ActuatorModule::remapHistory(Span<const ActuatorCommand> commands) {
+    const size_t count = commands.size();
+    batch_.fresh.clear();
+    bool same = batch_.channels.size() == count;
+    for (size_t i = 0; same && i < count; ++i) {
+        same = batch_.channels[i] == commands[i].id;
+    }
+    if (same) {
+        return;
+    }
+
+    std::unordered_map<SignalId, double> previous;
+    for (size_t i = 0; i < batch_.channels.size(); ++i) {
+        previous[batch_.channels[i]] = batch_.lastApplied[i];
+    }
+    batch_.channels.resize(count);
+    batch_.lastApplied.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        batch_.channels[i] = commands[i].id;
+        auto it = previous.find(commands[i].id);
+        if (it != previous.end()) {
+            batch_.lastApplied[i] = it->second;
+        } else {
+            batch_.lastApplied[i] = 0.0;
+            batch_.fresh.push_back(static_cast<uint32_t>(i));
+        }
+    }
+}
+
+void ActuatorModule::applyBatch(Span<const ActuatorCommand> commands) {
+    for (const auto& cmd : commands) {
+        execute(cmd);
+    }
+}
+
+} // namespace dcs
@@ -0,0 +1,790 @@
+#include <dcs/control_system.h>
+#include <dcs/replay.h>
+#include <dcs/utils/realtime.h>
+#include <algorithm>
+#include <cctype>
+#include <unistd.h>
+#include <stdexcept>
+
+namespace dcs {
+
+void ControlSystem::createControlLoop(const std::string& name, double frequency) {
+    if (!(frequency > 0.0)) {
+        throw std::invalid_argument("Control loop " + name + " needs a positive frequency");
+    }
+    std::lock_guard<std::mutex> lock(loopsMutex_);
+    if (controlLoops_.count(name)) {
+        throw ControlSystemException("Control loop already exists: " + name);
+    }
+    auto loop = std::make_unique<ControlLoop>();
+    loop->name = name;
+    loop->frequency = frequency;
+    controlLoops_.emplace(name, std::move(loop));
+}
+
+void ControlSystem::createControlLoop(const std::string& name, double frequency, WaitMode waitMode) {
+    createControlLoop(name, frequency);
+    std::lock_guard<std::mutex> lock(loopsMutex_);
+    controlLoops_.at(name)->waitMode = waitMode;
+}
+
+void ControlSystem::setControlFunction(const std::string& loopName, ActuatorCallback func) {
+    installControl(loopName, std::move(func), nullptr);
+}
+
+void ControlSystem::setControlFunction(const std::string& loopName, MimoControlFunction func) {
+    installControl(loopName, std::move(func), nullptr);
+}
+
+// The cycle calls the function and reads the buffers prepared here unlocked
+void ControlSystem::installControl(const std::string& loopName, ActuatorCallback func, std::shared_ptr<void> state) {
+    if (running_) {
+        throw std::logic_error("Cannot replace control of loop " + loopName + " while the system is running");
+    }
+    std::lock_guard<std::mutex> lock(loopsMutex_);
+    auto it = controlLoops_.find(loopName);
+    if (it == controlLoops_.end()) {
+        throw ControlSystemException("Unknown control loop: " + loopName);
+    }
+    ControlLoop* loop = it->second.get();
+    loop->controlFunction = std::move(func);
+    loop->controlState = std::move(state);
+    loop->mimoControlFunction = nullptr;
+    loop->mimoControlState.reset();
+    prepareCycleBuffers(loop);
+    armLoop(loop);
+}
+
+void ControlSystem::installControl(const std::string& loopName, MimoControlFunction func,
+                                   std::shared_ptr<void> state) {
+    if (running_) {
+        throw std::logic_error("Cannot replace control of loop " + loopName + " while the system is running");
+    }
+    std::lock_guard<std::mutex> lock(loopsMutex_);
+    auto it = controlLoops_.find(loopName);
+    if (it == controlLoops_.end()) {
+        throw ControlSystemException("Unknown control loop: " + loopName);
+    }
+    ControlLoop* loop = it->second.get();
+    loop->mimoControlFunction = std::move(func);
+    loop->mimoControlState = std::move(state);
+    prepareCycleBuffers(loop);
+    armLoop(loop);
+}
+
+// Wiring only changes while stopped; the cycle reads these vectors unlocked
+void ControlSystem::addSensorToLoop(const std::string& loopName, const std::string& sensorName) {
+    if (running_) {
+        throw std::logic_error("Cannot rewire loop " + loopName + " while the system is running");
+    }
+    std::lock_guard<std::mutex> lock(loopsMutex_);
+    auto it = controlLoops_.find(loopName);
+    if (it == controlLoops_.end()) {
+        throw ControlSystemException("Unknown control loop: " + loopName);
+    }
+    it->second->sensorModules.push_back(sensorName);
+    it->second->sensorSignals.push_back(SignalRegistry::instance().intern(sensorName));
+}
+
+void ControlSystem::addActuatorToLoop(const std::string& loopName, const std::string& actuatorName) {
+    if (running_) {
+        throw std::logic_error("Cannot rewire loop " + loopName + " while the system is running");
+    }
+    std::lock_guard<std::mutex> lock(loopsMutex_);
+    auto it = controlLoops_.find(loopName);
+    if (it == controlLoops_.end()) {
+        throw ControlSystemException("Unknown control loop: " + loopName);
+    }
+    ControlLoop* loop = it->second.get();
+    loop->actuatorModules.push_back(actuatorName);
+    loop->actuatorSignals.push_back(SignalRegistry::instance().intern(actuatorName));
+    loop->commands.clear();     // Re-stamped with the new ids by prepareCycleBuffers
+}
+
+void ControlSystem::setLoopTimeout(const std::string& loopName, std::chrono::microseconds timeout) {
+    std::lock_guard<std::mutex> lock(loopsMutex_);
+    auto it = controlLoops_.find(loopName);
+    if (it == controlLoops_.end()) {
+        throw ControlSystemException("Unknown control loop: " + loopName);
+    }
+    watchLoop(it->second.get(), timeout);
+}
+
+void ControlSystem::setLoopTiming(const std::string& loopName, const TimingPolicy& policy) {
+    if (running_) {
+        throw std::logic_error("Cannot change timing of loop " + loopName + " while the system is running");
+    }
+    std::lock_guard<std::mutex> lock(loopsMutex_);
+    auto it = controlLoops_.find(loopName);
+    if (it == controlLoops_.end()) {
+        throw ControlSystemException("Unknown control loop: " + loopName);
+    }
+    it->second->timing = policy;
+}
+
+void ControlSystem::setLoopTrigger(const std::string& loopName, const TriggerPolicy& policy) {
+    if (running_) {
+        throw std::logic_error("Cannot change trigger of loop " + loopName + " while the system is running");
+    }
+    if (!sensorBoard_) {
+        throw ControlSystemException("Event-driven loop " + loopName + " needs the sensor board");
+    }
+    std::lock_guard<std::mutex> lock(loopsMutex_);
+    auto it = controlLoops_.find(loopName);
+    if (it == controlLoops_.end()) {
+        throw ControlSystemException("Unknown control loop: " + loopName);
+    }
+    const auto& sensors = it->second->sensorModules;
+    for (const auto& name : policy.sensors) {
+        if (std::find(sensors.begin(), sensors.end(), name) == sensors.end()) {
+            throw ControlSystemException("Trigger sensor " + name + " is not an input of loop " + loopName);
+        }
+    }
+    it->second->trigger = policy;
+}
+
+void ControlSystem::runEventLoop(ControlLoop* loop) {
+    // Bounds how long stop() waits for this thread
+    constexpr auto WAIT_SLICE = std::chrono::milliseconds(100);
+
+    const TriggerPolicy& policy = *loop->trigger;
+    std::vector<ModuleHandle<SensorModule>> watched;
+    for (const auto& name : policy.sensors.empty() ? loop->sensorModules : policy.sensors) {
+        watched.push_back(resolveModule<SensorModule>(name));
+    }
+
+    EventTrigger trigger(*sensorBoard_, {}, policy.quorum, policy.minInterArrival);
+    std::vector<SignalId> signals(watched.size(), INVALID_SIGNAL);
+    while (loop->running.load(std::memory_order_relaxed)) {
+        // A sensor's signal is known once it has published; keep looking until all are
+        if (std::find(signals.begin(), signals.end(), INVALID_SIGNAL) != signals.end()) {
+            EpochGuard guard;
+            for (size_t i = 0; i < watched.size(); ++i) {
+                SensorModule* sensor = getModule(watched[i]);
+                signals[i] = sensor ? sensor->publishedSignal() : INVALID_SIGNAL;
+            }
+            trigger.setSignals(signals);
+        }
+        if (trigger.wait(WAIT_SLICE)) {
+            runControlLoop(loop);
+        }
+    }
+}
+
+void ControlSystem::addAcquisitionTask(const std::string& sensorName) {
+    auto handle = resolveModule<SensorModule>(sensorName);
+    double rate = 0.0;
+    {
+        EpochGuard guard;
+        SensorModule* sensor = getModule(handle);
+        if (!sensor) {
+            return;     // The event loop reports it
+        }
+        rate = sensor->getUpdateRate();
+    }
+    scheduler_->addTask("acquire " + sensorName, rate, [this, handle, sensorName]() {
+        EpochGuard guard;
+        SensorModule* sensor = getModule(handle);
+        if (!sensor) {
+            return;
+        }
+        try {
+            SensorData sample = sensor->poll();     // Publishes to the board, which wakes the loop
+            sensor->heartbeat();
+            if (sample.payload && sharedPool_) {
+                SharedPayload::adopt(*sharedPool_, sample.payload);
+            }
+        } catch (const std::exception& e) {
+            handleError(sensorName, e.what());
+        }
+    });
+}
+
+std::shared_ptr<const DataflowSchedule> ControlSystem::addDataflowGraph(const std::string& name,
+                                                                        DataflowGraph graph) {
+    const auto& nodes = graph.nodes();
+    for (DataflowGraph::NodeId id = 0; id < nodes.size(); ++id) {
+        const auto& node = nodes[id];
+        if (node.kind == DataflowGraph::Kind::SENSOR && !node.read) {
+            auto handle = resolveModule<SensorModule>(node.name);
+            if (!handle.isValid()) {
+                throw ControlSystemException("Dataflow sensor not loaded: " + node.name);
+            }
+            // Edges carry values only; a frame payload is released right away
+            // since a held sample may be read again many cycles later
+            graph.bindSensor(id, [this, handle, name = node.name]() {
+                SensorModule* sensor = getModule(handle);
+                if (!sensor) {
+                    throw ControlSystemException("Sensor not loaded for dataflow: " + name);
+                }
+                SensorData sample = sensor->poll();
+                sensor->heartbeat();
+                if (sample.payload && sharedPool_) {
+                    SharedPayload::adopt(*sharedPool_, sample.payload);
+                }
+                sample.payload = PayloadRef{};
+                return sample;
+            });
+        } else if (node.kind == DataflowGraph::Kind::ACTUATOR && !node.write) {
+            auto handle = resolveModule<ActuatorModule>(node.name);
+            if (!handle.isValid()) {
+                throw ControlSystemException("Dataflow actuator not loaded: " + node.name);
+            }
+            graph.bindActuator(id, [this, handle, name = node.name](const ActuatorCommand& cmd) {
+                ActuatorModule* actuator = getModule(handle);
+                if (!actuator) {
+                    throw ControlSystemException("Actuator not loaded for dataflow: " + name);
+                }
+                if (actuator->isSafeToExecute(cmd)) {
+                    actuator->execute(cmd);
+                    actuator->heartbeat();
+                }
+            });
+        }
+    }
+
+    std::shared_ptr<DataflowSchedule> schedule;
+    try {
+        schedule = std::make_shared<DataflowSchedule>(graph.compile());
+    } catch (const std::invalid_argument& e) {
+        throw ControlSystemException("Dataflow graph " + name + ": " + e.what());
+    }
+
+    for (size_t branch = 0; branch < schedule->branchCount(); ++branch) {
+        std::string loopName = name + "/" + std::to_string(branch);
+        createControlLoop(loopName, schedule->branchRate(branch));
+        std::lock_guard<std::mutex> lock(loopsMutex_);
+        ControlLoop* loop = controlLoops_.at(loopName).get();
+        loop->dataflow = schedule;
+        loop->dataflowBranch = branch;
+        if (!loop->recorder && config_.flightRecorderRecords > 0) {
+            loop->recorder = flightRecorder_.addChannel(loop->name, config_.flightRecorderRecords);
+        }
+        armLoop(loop);
+    }
+    return schedule;
+}
+
+void ControlSystem::runDataflowCycle(ControlLoop* loop) {
+    // Modules bound to the graph's IO nodes stay alive for the whole branch
+    EpochGuard guard;
+    auto start = TscClock::now();
+    uint64_t cycle = loop->cycleCount++;
+    try {
+        loop->dataflow->runBranch(loop->dataflowBranch, cycle);
+    } catch (const std::exception& e) {
+        handleError(loop->name, e.what());
+        return;
+    }
+    if (FlightRecorder::Channel* recorder = loop->recorder) {
+        int64_t readAt = start.time_since_epoch().count();
+        int64_t sentAt = TscClock::now().time_since_epoch().count();
+        loop->dataflow->forEachIo(
+            loop->dataflowBranch, cycle,
+            [recorder, readAt, cycle](const SensorData& sample) { recorder->recordSample(readAt, cycle, sample); },
+            [recorder, sentAt, cycle](const ActuatorCommand& cmd) { recorder->recordCommand(sentAt, cycle, cmd); });
+    }
+    loop->latency.record(elapsedNs(start));
+    loop->heartbeat.beat();
+}
+
+// Called with loopsMutex_ held once a loop has something to run: a control
+// function or a dataflow branch
+void ControlSystem::armLoop(ControlLoop* loop) {
+    TscClock::now();    // Calibrate here rather than in the first cycle
+    if (loop->watch == INVALID_WATCH) {
+        auto period = std::chrono::microseconds(static_cast<int64_t>(1e6 / loop->frequency));
+        watchLoop(loop, std::min<std::chrono::microseconds>(period * 10, config_.watchdogTimeout));
+    }
+}
+
+// Called with loopsMutex_ held. The watch is registered disarmed, so its
+// Heartbeat never changes under a running loop; start() arms it with timeout.
+void ControlSystem::watchLoop(ControlLoop* loop, std::chrono::microseconds timeout) {
+    if (loop->watch == INVALID_WATCH) {
+        loop->watch = watchdog_.watch(loop->name, std::chrono::microseconds(0),
+                                      [this](WatchId, const std::string& name, uint64_t missed) {
+                                          onWatchdogExpiry(name, missed);
+                                      });
+        loop->heartbeat = watchdog_.heartbeat(loop->watch);
+    }
+    loop->watchTimeout = timeout;
+    if (running_) {
+        loop->heartbeat.beat();
+        watchdog_.setTimeout(loop->watch, timeout);
+        if (timeout.count() > 0) {
+            reportRealtime(watchdog_.start());
+        }
+    }
+}
+
+void ControlSystem::armWatches(bool armed) {
+    const std::chrono::microseconds off(0);
+    {
+        std::lock_guard<std::mutex> lock(loopsMutex_);
+        for (auto& entry : controlLoops_) {
+            ControlLoop* loop = entry.second.get();
+            if (loop->watch == INVALID_WATCH) {
+                continue;
+            }
+            if (armed) {
+                loop->heartbeat.beat();     // Deadlines count from now, not from the last run
+            }
+            watchdog_.setTimeout(loop->watch, armed ? loop->watchTimeout : off);
+        }
+    }
+    std::lock_guard<std::mutex> lock(modulesMutex_);
+    for (auto& entry : modules_) {
+        ModuleInfo& info = entry.second;
+        if (info.watch == INVALID_WATCH) {
+            continue;
+        }
+        if (armed) {
+            info.module->heartbeat();
+        }
+        watchdog_.setTimeout(info.watch, armed ? info.watchTimeout : off);
+    }
+}
+
+void ControlSystem::onWatchdogExpiry(const std::string& name, uint64_t missedTicks) {
+    auto silent = std::chrono::duration_cast<std::chrono::milliseconds>(watchdog_.tickPeriod() * missedTicks);
+    handleError(name, "Watchdog: no heartbeat for " + std::to_string(silent.count()) + " ms");
+    // A cascade of expiries should not write a file per watch: at most one per
+    // second. Only expiries count, so the emergency stop that often follows
+    // still gets its own dump.
+    constexpr int64_t MIN_INTERVAL_NS = 1000000000;
+    int64_t now = TscClock::now().time_since_epoch().count();
+    int64_t last = lastFaultDumpNs_.load();
+    if ((last != 0 && now - last < MIN_INTERVAL_NS) || !lastFaultDumpNs_.compare_exchange_strong(last, now)) {
+        return;
+    }
+    dumpOnFault("watchdog " + name);
+}
+
+std::string ControlSystem::dumpFlightRecorder(const std::string& reason, const std::string& path) {
+    std::string target = path;
+    if (target.empty()) {
+        std::string tag;
+        for (char c : reason) {
+            tag += std::isalnum(static_cast<unsigned char>(c)) ? c : '_';
+        }
+        target = config_.flightRecorderDir + "/dcs-flight-" + std::to_string(getpid()) + "-" +
+                 std::to_string(flightDumps_.fetch_add(1)) + "-" + tag + ".bin";
+    }
+    try {
+        flightRecorder_.dump(target, reason);
+    } catch (const FlightRecorderException& e) {
+        throw ControlSystemException(std::string("Flight recorder dump failed: ") + e.what());
+    }
+    return target;
+}
+
+void ControlSystem::dumpOnFault(const std::string& reason) {
+    if (flightRecorder_.channelCount() == 0) {
+        return;
+    }
+    // Writing the file (open, mmap, sort, msync) would hold up the watchdog's
+    // other deadlines or the emergency stop; hand it to the dump thread
+    std::lock_guard<std::mutex> lock(dumpMutex_);
+    if (dumpStopping_) {
+        return;
+    }
+    pendingDumps_.push_back(reason);
+    if (!dumpThread_.joinable()) {
+        dumpThread_ = std::thread(&ControlSystem::runDumps, this);
+        reportRealtime(setThreadAffinity(dumpThread_.native_handle(), housekeepingCpus()));
+    }
+    dumpWake_.notify_one();
+}
+
+void ControlSystem::runDumps() {
+    std::unique_lock<std::mutex> lock(dumpMutex_);
+    for (;;) {
+        dumpWake_.wait(lock, [this]() { return dumpStopping_ || !pendingDumps_.empty(); });
+        if (pendingDumps_.empty()) {
+            return;
+        }
+        std::string reason = std::move(pendingDumps_.front());
+        pendingDumps_.erase(pendingDumps_.begin());
+        lock.unlock();
+        try {
+            std::string path = dumpFlightRecorder(reason);
+            handleError("ControlSystem", "Flight recorder dumped to " + path + " (" + reason + ")");
+        } catch (const std::exception& e) {
+            handleError("ControlSystem", e.what());
+        }
+        lock.lock();
+    }
+}
+
+// Swapped atomically, so a running loop picks a capture up or drops it
+// between cycles; a cycle keeps the writer it loaded until it finishes
+void ControlSystem::captureLoop(const std::string& loopName, const std::string& path) {
+    std::shared_ptr<ReplayWriter> previous;
+    {
+        std::lock_guard<std::mutex> lock(loopsMutex_);
+        auto it = controlLoops_.find(loopName);
+        if (it == controlLoops_.end()) {
+            throw ControlSystemException("Unknown control loop: " + loopName);
+        }
+        ControlLoop* loop = it->second.get();
+        ReplayHeader header{loop->name, loop->frequency, loop->sensorModules, loop->actuatorModules};
+        std::shared_ptr<ReplayWriter> capture;
+        try {
+            capture = std::make_shared<ReplayWriter>(path, header);
+        } catch (const ReplayException& e) {
+            throw ControlSystemException(std::string("Cannot capture loop ") + loopName + ": " + e.what());
+        }
+        previous = std::atomic_exchange(&loop->capture, std::move(capture));
+    }
+    finishCapture(loopName, std::move(previous));
+}
+
+void ControlSystem::endCapture(const std::string& loopName) {
+    std::shared_ptr<ReplayWriter> capture;
+    {
+        std::lock_guard<std::mutex> lock(loopsMutex_);
+        auto it = controlLoops_.find(loopName);
+        if (it == controlLoops_.end()) {
+            throw ControlSystemException("Unknown control loop: " + loopName);
+        }
+        capture = std::atomic_exchange(&it->second->capture, std::shared_ptr<ReplayWriter>());
+    }
+    finishCapture(loopName, std::move(capture));
+}
+
+void ControlSystem::finishCapture(const std::string& loopName, std::shared_ptr<ReplayWriter> capture) {
+    if (!capture) {
+        return;
+    }
+    // No new cycle can load it now; wait out the one that may still be
+    // appending, so the file is complete and it is not closed on the loop's thread
+    while (capture.use_count() > 1) {
+        std::this_thread::yield();
+    }
+    try {
+        capture->flush();
+    } catch (const ReplayException& e) {
+        throw ControlSystemException(std::string("Capture of loop ") + loopName + " incomplete: " + e.what());
+    }
+}
+
+void ControlSystem::setLoopClock(const std::string& loopName, std::shared_ptr<const VirtualClock> clock) {
+    if (running_) {
+        throw std::logic_error("Cannot change clock of loop " + loopName + " while the system is running");
+    }
+    std::lock_guard<std::mutex> lock(loopsMutex_);
+    auto it = controlLoops_.find(loopName);
+    if (it == controlLoops_.end()) {
+        throw ControlSystemException("Unknown control loop: " + loopName);
+    }
+    it->second->clock = std::move(clock);
+}
+
+void ControlSystem::stepLoop(const std::string& loopName, uint64_t cycle) {
+    if (running_) {
+        throw std::logic_error("Cannot step loop " + loopName + " while the system is running");
+    }
+    ControlLoop* loop = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(loopsMutex_);
+        auto it = controlLoops_.find(loopName);
+        if (it == controlLoops_.end()) {
+            throw ControlSystemException("Unknown control loop: " + loopName);
+        }
+        loop = it->second.get();
+        // Rewired since the function was set; start() does the same
+        const ControlLoop::Handles* handles = loop->handles.load(std::memory_order_relaxed);
+        if (handles && (handles->sensors.size() != loop->sensorModules.size() ||
+                        handles->actuators.size() != loop->actuatorModules.size())) {
+            prepareCycleBuffers(loop);
+        }
+    }
+    loop->cycleCount = cycle;
+    runControlLoop(loop);
+}
+
+LoopScheduler::Options ControlSystem::schedulerOptions() {
+    LoopScheduler::Options options;
+    options.workerCount = config_.schedulerThreads;
+    options.cpus = config_.schedulerCpus;
+    options.prefaultStackBytes = config_.prefault ? config_.prefaultStackBytes : 0;
+    options.wait = config_.loopWait;
+    options.onSetupWarning = [this](const std::string& error) { reportRealtime(error); };
+    return options;
+}
+
+void ControlSystem::setupRealtime() {
+    if (config_.lockMemory) {
+        reportRealtime(lockProcessMemory());
+    }
+    if (config_.prefault && sharedMemory_) {
+        prefaultMemory(sharedMemory_->data(), sharedMemory_->size());
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(loopsMutex_);
+        for (const auto& entry : controlLoops_) {
+            if (entry.second->waitMode && scheduler_ && entry.second->schedulerTask < scheduler_->taskCount()) {
+                scheduler_->setWaitMode(entry.second->schedulerTask, *entry.second->waitMode);
+            }
+        }
+        for (const auto& entry : config_.loopPriorities) {
+            auto it = controlLoops_.find(entry.first);
+            if (it != controlLoops_.end() && it->second->trigger) {
+                continue;   // Applied to its thread once started
+            }
+            if (it == controlLoops_.end() || !scheduler_ ||
+                it->second->schedulerTask >= scheduler_->taskCount()) {
+                reportRealtime("priority given for unknown loop " + entry.first);
+                continue;
+            }
+            scheduler_->setPriority(it->second->schedulerTask, entry.second);
+        }
+    }
+
+    if (config_.isolation == IsolationPolicy::HOUSEKEEPING_OFF_RT) {
+        std::vector<int> cpus = housekeepingCpus();
+        if (cpus.empty()) {
+            reportRealtime("no CPU left for housekeeping threads outside the scheduler CPUs");
+            return;
+        }
+        reportRealtime(watchdog_.setCpus(cpus));
+    }
+}
+
+std::vector<int> ControlSystem::housekeepingCpus() const {
+    if (config_.isolation != IsolationPolicy::HOUSEKEEPING_OFF_RT) {
+        return {};
+    }
+    return config_.housekeepingCpus.empty() ? cpusExcluding(config_.schedulerCpus) : config_.housekeepingCpus;
+}
+
+void ControlSystem::reportRealtime(const std::string& error) {
+    if (!error.empty()) {
+        handleError("ControlSystem", "Real-time setup: " + error);
+    }
+}
+
+// Size the snapshot and command buffers to the loop's wiring so the cycle
+// itself never allocates. Called at setup and again only if the wiring changed.
+void ControlSystem::prepareCycleBuffers(ControlLoop* loop) {
+    loop->snapshot.resize(loop->sensorModules.size());
+    loop->vectors.resize(loop->sensorModules.size());
+    if (!loop->recorder && config_.flightRecorderRecords > 0) {
+        loop->recorder = flightRecorder_.addChannel(loop->name, config_.flightRecorderRecords);
+    }
+
+    resolveLoopHandles(loop);
+
+    if (loop->commands.size() != loop->actuatorModules.size()) {
+        loop->commands.resize(loop->actuatorModules.size());
+        auto& registry = SignalRegistry::instance();
+        for (size_t i = 0; i < loop->commands.size(); ++i) {
+            loop->commands[i].id = i < loop->actuatorSignals.size()
+                ? loop->actuatorSignals[i]
+                : registry.intern(loop->actuatorModules[i]);
+        }
+    }
+}
+
+// Called with loopsMutex_ held and never on a cycle thread: resolving locks,
+// allocates and may load a deferred module. A cycle already running keeps the
+// set it read until it leaves its EpochGuard.
+void ControlSystem::resolveLoopHandles(ControlLoop* loop) {
+    auto handles = std::make_shared<ControlLoop::Handles>();
+    for (const auto& name : loop->sensorModules) {
+        handles->sensors.push_back(resolveModule<SensorModule>(name));
+    }
+    for (const auto& name : loop->actuatorModules) {
+        handles->actuators.push_back(resolveModule<ActuatorModule>(name));
+    }
+    std::shared_ptr<const ControlLoop::Handles> previous = std::move(loop->handlesOwner);
+    loop->handlesOwner = handles;
+    loop->handles.store(handles.get(), std::memory_order_release);
+    if (previous) {
+        EpochDomain::instance().retire([previous]() {});
+    }
+}
+
+// Unloading leaves a loop's handles resolving to nullptr and a swap keeps them
+// valid, so only a load can give a wired name a module to point at
+void ControlSystem::rebindLoops(const ModuleLoadReport& report) {
+    auto wired = [&report](const std::vector<std::string>& names) {
+        for (const auto& record : report.modules) {
+            if (record.success && std::find(names.begin(), names.end(), record.name) != names.end()) {
+                return true;
+            }
+        }
+        return false;
+    };
+    std::lock_guard<std::mutex> lock(loopsMutex_);
+    for (auto& entry : controlLoops_) {
+        ControlLoop* loop = entry.second.get();
+        if (loop->handlesOwner && (wired(loop->sensorModules) || wired(loop->actuatorModules))) {
+            resolveLoopHandles(loop);
+        }
+    }
+}
+
+SystemMetrics ControlSystem::getMetrics() const {
+    SystemMetrics snapshot;
+    {
+        std::lock_guard<std::mutex> lock(metricsMutex_);
+        snapshot = metrics_;
+    }
+    LatencyHistogram merged;
+    snapshot.missedDeadlines = 0;
+
+    std::lock_guard<std::mutex> lock(loopsMutex_);
+    for (const auto& entry : controlLoops_) {
+        snapshot.loopLatency[entry.first] = entry.second->latency.summary();
+        merged.merge(entry.second->latency);
+        if (scheduler_ && entry.second->schedulerTask < scheduler_->taskCount()) {
+            LoopTimingStats timing = scheduler_->getStats(entry.second->schedulerTask);
+            snapshot.missedDeadlines += timing.missedDeadlines;
+            snapshot.loopTiming[entry.first] = timing;
+        }
+    }
+    snapshot.latency = merged.summary();
+    if (snapshot.latency.count > 0) {
+        snapshot.avgLatency = snapshot.latency.mean * 1e-3;                      // μs
+        snapshot.maxLatency = static_cast<double>(snapshot.latency.max) * 1e-3;
+    }
+    return snapshot;
+}
+
+// One cycle of any kind of loop; the scheduler, event threads and stepLoop() all come here
+void ControlSystem::runControlLoop(ControlLoop* loop) {
+    if (loop->dataflow) {
+        runDataflowCycle(loop);
+    } else if (loop->mimoControlFunction || loop->controlFunction) {
+        runMimoCycle(loop);
+    }
+}
+
+void ControlSystem::runMimoCycle(ControlLoop* loop) {
+    // Modules looked up below stay alive until the guard is released, even if
+    // they are unloaded or swapped concurrently; so does the handle set
+    EpochGuard guard;
+    const ControlLoop::Handles& handles = *loop->handles.load(std::memory_order_acquire);
+
+    // Each sample's payload reference lasts for this cycle only; controllers
+    // that keep a frame longer take their own with SharedPayload::retain()
+    auto releasePayloads = [this, loop]() {
+        for (auto& sample : loop->snapshot) {
+            if (sample.payload && sharedPool_) {
+                SharedPayload::adopt(*sharedPool_, sample.payload);
+            }
+            sample.payload = PayloadRef{};
+        }
+    };
+
+    // Read every sensor back-to-back so the snapshot is time-coherent
+    auto start = TscClock::now();
+    SensorSnapshot inputs;
+    inputs.timestamp = loop->clock ? loop->clock->now() : start;
+    inputs.cycle = loop->cycleCount++;
+    for (size_t i = 0; i < loop->sensorModules.size(); ++i) {
+        SensorModule* sensor = getModule(handles.sensors[i]);
+        if (!sensor) {
+            // Loading it again republishes the handles; the cycle never resolves names
+            handleError(loop->sensorModules[i], "Sensor not loaded for loop " + loop->name);
+            releasePayloads();
+            return;
+        }
+        if (loop->trigger) {
+            // Event-driven: the sensor publishes on its own; polling here would re-trigger us.
+            // The board holds scalars only.
+            SignalId signal = sensor->publishedSignal();
+            loop->vectors[i].clear();
+            if (!sensorBoard_->read(signal, loop->snapshot[i])) {
+                loop->snapshot[i] = SensorData();
+                loop->snapshot[i].id = signal;
+            }
+            continue;
+        }
+        try {
+            loop->snapshot[i] = sensor->poll(loop->vectors[i]);
+            sensor->heartbeat();
+        } catch (const std::exception& e) {
+            handleError(loop->sensorModules[i], e.what());
+            releasePayloads();
+            return;
+        }
+    }
+    inputs.samples = Span<const SensorData>(loop->snapshot);
+    inputs.vectors = Span<const VectorSample>(loop->vectors);
+    std::shared_ptr<ReplayWriter> capture = std::atomic_load(&loop->capture);
+    if (loop->recorder) {
+        int64_t readAt = inputs.timestamp.time_since_epoch().count();     // TscClock ticks are ns
+        for (const auto& sample : loop->snapshot) {
+            loop->recorder->recordSample(readAt, inputs.cycle, sample);
+        }
+    }
+
+    try {
+        if (loop->mimoControlFunction) {
+            loop->mimoControlFunction(inputs, Span<ActuatorCommand>(loop->commands));
+        } else {
+            runSisoControl(loop, inputs);
+        }
+    } catch (const std::exception& e) {
+        handleError(loop->name, e.what());
+        if (capture) {
+            capture->append(inputs.cycle, inputs.timestamp, inputs.samples, inputs.vectors, {}, true);
+        }
+        releasePayloads();
+        return;
+    }
+    if (capture) {
+        capture->append(inputs.cycle, inputs.timestamp, inputs.samples, inputs.vectors,
+                              Span<const ActuatorCommand>(loop->commands), false);
+    }
+    releasePayloads();
+    if (loop->recorder) {
+        int64_t sentAt = (loop->clock ? loop->clock->now() : TscClock::now()).time_since_epoch().count();
+        for (const auto& cmd : loop->commands) {
+            loop->recorder->recordCommand(sentAt, inputs.cycle, cmd);
+        }
+    }
+
+    // A missing actuator must not stop the others from getting their commands
+    for (size_t i = 0; i < loop->actuatorModules.size(); ++i) {
+        ActuatorModule* actuator = getModule(handles.actuators[i]);
+        if (!actuator) {
+            handleError(loop->actuatorModules[i], "Actuator not loaded for loop " + loop->name);
+            continue;
+        }
+        const ActuatorCommand& cmd = loop->commands[i];
+        if (!actuator->isSafeToExecute(cmd)) {
+            continue;
+        }
+        try {
+            actuator->execute(cmd);
+            actuator->heartbeat();
+        } catch (const std::exception& e) {
+            handleError(loop->actuatorModules[i], e.what());
+        }
+    }
+
+    loop->latency.record(elapsedNs(start));
+    loop->heartbeat.beat();
+}
+
+// SISO: every sample goes through controlFunction on its own and the command
+// replaces the one for the actuator it targets; the rest keep their last value
+void ControlSystem::runSisoControl(ControlLoop* loop, const SensorSnapshot& inputs) {
+    for (const auto& sample : inputs.samples) {
+        ActuatorCommand cmd = loop->controlFunction(sample);
+        auto target = std::find_if(loop->commands.begin(), loop->commands.end(),
+                                   [&cmd](const ActuatorCommand& slot) { return slot.id == cmd.id; });
+        if (target == loop->commands.end()) {
+            throw ControlSystemException("Control function of loop " + loop->name +
+                                         " targets an actuator outside the loop");
+        }
+        *target = cmd;
+    }
+}
+
+} // namespace dcs
@@ -0,0 +1,275 @@
+#include <dcs/control_system.h>
+#include <dcs/utils/realtime.h>
+#include <algorithm>
+#include <fstream>
+#include <set>
+#include <time.h>
+#include <unistd.h>
+
+namespace dcs {
+
+namespace {
+
+// How often the metrics thread refreshes SystemMetrics and calls back
+constexpr auto METRICS_PERIOD = std::chrono::milliseconds(1000);
+// Bounds how long stop() waits for the metrics thread
+constexpr auto METRICS_SLICE = std::chrono::milliseconds(10);
+
+// Every ControlSystem in the process gets its own segment
+std::string segmentName() {
+    static std::atomic<uint32_t> instances{0};
+    return "/dcs-" + std::to_string(getpid()) + "-" + std::to_string(instances++);
+}
+
+std::chrono::nanoseconds processCpuTime() {
+    timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return std::chrono::seconds(ts.tv_sec) + std::chrono::nanoseconds(ts.tv_nsec);
+}
+
+// Resident set size in MB, 0 if /proc is unavailable
+double residentMegabytes() {
+    std::ifstream statm("/proc/self/statm");
+    size_t pages = 0;
+    size_t resident = 0;
+    if (!(statm >> pages >> resident)) {
+        return 0.0;
+    }
+    return static_cast<double>(resident) * static_cast<double>(sysconf(_SC_PAGESIZE)) / (1024.0 * 1024.0);
+}
+
+} // namespace
+
+ControlSystem::ControlSystem(const Config& config) : config_(config) {
+    metricsEnabled_ = config_.enableMetrics;
+    sharedMemory_ = std::make_shared<SharedMemory>(segmentName(), config_.sharedMemorySize);
+    messageQueue_ = std::make_shared<MessageQueue>(*sharedMemory_, "system", config_.messageQueueSize,
+                                                   config_.messageQueueMode);
+    if (config_.sensorBoardSlots > 0) {
+        sensorBoard_ = std::make_shared<SensorBoard>(*sharedMemory_, config_.sensorBoardSlots);
+    }
+    // The pool gets what it asked for or whatever the segment has left
+    if (config_.sharedPoolSize > 0) {
+        size_t left = sharedMemory_->available();
+        left = left > CACHE_LINE_SIZE ? (left - CACHE_LINE_SIZE) & ~(CACHE_LINE_SIZE - 1) : 0;
+        sharedPool_ = std::make_shared<SharedMemoryPool>(*sharedMemory_, std::min(config_.sharedPoolSize, left),
+                                                         "system");
+    }
+}
+
+ControlSystem::~ControlSystem() {
+    stop();
+    watchdog_.stop();
+    // Dumps already asked for are still written
+    {
+        std::lock_guard<std::mutex> lock(dumpMutex_);
+        dumpStopping_ = true;
+    }
+    dumpWake_.notify_one();
+    if (dumpThread_.joinable()) {
+        dumpThread_.join();
+    }
+    {
+        std::lock_guard<std::mutex> lock(modulesMutex_);
+        for (auto& entry : modules_) {
+            if (entry.second.module->getState() != ModuleState::SHUTDOWN) {
+                entry.second.module->shutdown();
+            }
+        }
+    }
+    // Run the deferred teardown of swapped and unloaded modules while their
+    // libraries are still ours to close
+    EpochDomain::instance().synchronize();
+}
+
+void ControlSystem::start() {
+    if (running_) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(metricsMutex_);
+        metrics_ = SystemMetrics{};
+        metrics_.startTime = std::chrono::steady_clock::now();
+    }
+    // A fresh scheduler per start(): tasks can only be added while stopped,
+    // and loops created since the last run join this one
+    {
+        std::lock_guard<std::mutex> lock(loopsMutex_);
+        scheduler_ = std::make_unique<LoopScheduler>(schedulerOptions());
+        std::set<std::string> polled;
+        std::set<std::string> triggering;
+        for (auto& entry : controlLoops_) {
+            ControlLoop* loop = entry.second.get();
+            if (loop->mimoControlFunction || loop->controlFunction) {
+                prepareCycleBuffers(loop);  // Modules loaded since the wiring was set
+            }
+            loop->running = true;
+            if (loop->trigger) {
+                // Runs on its own thread, started below once the modules are
+                loop->schedulerTask = SIZE_MAX;
+                triggering.insert(loop->sensorModules.begin(), loop->sensorModules.end());
+                continue;
+            }
+            const auto& inputs = loop->dataflow ? loop->dataflow->executionOrder(loop->dataflowBranch)
+                                                : loop->sensorModules;
+            polled.insert(inputs.begin(), inputs.end());
+            loop->schedulerTask = scheduler_->addTask(loop->name, loop->frequency,
+                                                      [this, loop]() { runControlLoop(loop); }, loop->timing);
+        }
+        // Event-driven loops only read the board; sensors no periodic loop polls
+        // are polled at their own update rate so they have something to publish
+        for (const auto& name : triggering) {
+            if (!polled.count(name)) {
+                addAcquisitionTask(name);
+            }
+        }
+    }
+    // After the loops: wiring them loads any deferred modules they use
+    {
+        std::lock_guard<std::mutex> lock(modulesMutex_);
+        for (auto& entry : modules_) {
+            ModuleState state = entry.second.module->getState();
+            if (state == ModuleState::READY || state == ModuleState::PAUSED) {
+                entry.second.module->start();
+            }
+        }
+    }
+    // Priorities and wait modes can only be set before the workers start
+    setupRealtime();
+    running_ = true;
+    scheduler_->start();
+    {
+        std::lock_guard<std::mutex> lock(loopsMutex_);
+        for (auto& entry : controlLoops_) {
+            ControlLoop* loop = entry.second.get();
+            if (!loop->trigger) {
+                continue;
+            }
+            loop->eventThread = std::thread([this, loop]() { runEventLoop(loop); });
+            auto priority = config_.loopPriorities.find(loop->name);
+            if (priority != config_.loopPriorities.end()) {
+                reportRealtime(setThreadPriority(loop->eventThread.native_handle(), priority->second));
+            }
+        }
+    }
+    // Deadlines only while running: a stopped loop or idle module is not a fault
+    armWatches(true);
+    if (watchdog_.watchCount() > 0) {
+        reportRealtime(watchdog_.start());
+    }
+
+    if (metricsEnabled_) {
+        lastCpuTime_ = processCpuTime();
+        lastMetricsUpdate_ = std::chrono::steady_clock::now();
+        metricsThread_ = std::thread([this]() {
+            auto next = std::chrono::steady_clock::now();
+            while (running_) {
+                updateMetrics();
+                next += METRICS_PERIOD;
+                while (running_ && std::chrono::steady_clock::now() < next) {
+                    std::this_thread::sleep_for(METRICS_SLICE);
+                }
+            }
+        });
+        std::vector<int> cpus = housekeepingCpus();
+        if (!cpus.empty()) {
+            reportRealtime(setThreadAffinity(metricsThread_.native_handle(), cpus));
+        }
+    }
+}
+
+void ControlSystem::stop() {
+    if (!running_) {
+        return;
+    }
+    // Loops first: once the scheduler has joined its workers no cycle is in flight
+    if (scheduler_) {
+        scheduler_->stop();
+    }
+    std::vector<std::thread> eventThreads;
+    {
+        std::lock_guard<std::mutex> lock(loopsMutex_);
+        for (auto& entry : controlLoops_) {
+            entry.second->running = false;
+            if (entry.second->eventThread.joinable()) {
+                eventThreads.push_back(std::move(entry.second->eventThread));
+            }
+        }
+    }
+    // Each notices within its wait slice
+    for (auto& thread : eventThreads) {
+        thread.join();
+    }
+    running_ = false;
+    armWatches(false);
+    if (metricsThread_.joinable()) {
+        metricsThread_.join();
+    }
+
+    std::lock_guard<std::mutex> lock(modulesMutex_);
+    for (auto& entry : modules_) {
+        entry.second.module->stop();
+    }
+}
+
+void ControlSystem::emergencyStop() {
+    // Latch every actuator first so nothing more goes out, even from a cycle
+    // already past its sensor reads
+    {
+        std::lock_guard<std::mutex> lock(modulesMutex_);
+        for (auto& entry : modules_) {
+            if (auto* actuator = dynamic_cast<ActuatorModule*>(entry.second.module.get())) {
+                actuator->setEmergencyStop(true);
+            }
+        }
+    }
+    handleError("ControlSystem", "Emergency stop");
+    dumpOnFault("emergency stop");
+    stop();
+}
+
+void ControlSystem::setMetricsCallback(std::function<void(const SystemMetrics&)> callback) {
+    std::lock_guard<std::mutex> lock(metricsMutex_);
+    metricsCallback_ = std::move(callback);
+}
+
+// Metrics thread only
+void ControlSystem::updateMetrics() {
+    auto now = std::chrono::steady_clock::now();
+    auto cpuTime = processCpuTime();
+    double wall = std::chrono::duration<double>(now - lastMetricsUpdate_).count();
+    double cpus = std::max(1u, std::thread::hardware_concurrency());
+    double cpuUsage = wall > 0.0 ? std::chrono::duration<double>(cpuTime - lastCpuTime_).count() / wall / cpus * 100.0
+                                 : 0.0;
+    lastCpuTime_ = cpuTime;
+    lastMetricsUpdate_ = now;
+
+    {
+        std::lock_guard<std::mutex> lock(metricsMutex_);
+        metrics_.cpuUsage = std::min(100.0, std::max(0.0, cpuUsage));
+        metrics_.memoryUsage = residentMegabytes();
+        metrics_.droppedMessages = messageQueue_ ? messageQueue_->droppedCount() : 0;
+    }
+    SystemMetrics snapshot = getMetrics();
+
+    std::function<void(const SystemMetrics&)> callback;
+    {
+        std::lock_guard<std::mutex> lock(metricsMutex_);
+        callback = metricsCallback_;
+    }
+    if (callback) {
+        callback(snapshot);
+    }
+}
+
+bool ControlSystem::validateModuleCompatibility(const Module* module) {
+    return module && !module->getName().empty() && !module->getVersion().empty();
+}
+
+void ControlSystem::handleError(const std::string& module, const std::string& error) {
+    if (errorCallback_) {
+        errorCallback_(module, error);
+    }
+}
+
+} // namespace dcs
@@ -0,0 +1,258 @@
+#include <dcs/dataflow.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <numeric>
+#include <stdexcept>
+
+namespace dcs {
+
+namespace {
+
+size_t findRoot(std::vector<size_t>& parent, size_t i) {
+    while (parent[i] != i) {
+        parent[i] = parent[parent[i]];
+        i = parent[i];
+    }
+    return i;
+}
+
+} // namespace
+
+DataflowGraph::NodeId DataflowGraph::addNode(Node node) {
+    if (!(node.rate > 0.0)) {
+        throw std::invalid_argument("Dataflow node " + node.name + " needs a positive rate");
+    }
+    nodes_.push_back(std::move(node));
+    return static_cast<NodeId>(nodes_.size() - 1);
+}
+
+DataflowGraph::NodeId DataflowGraph::addSensor(const std::string& name, double rate, SourceFunction read) {
+    return addNode(Node{name, Kind::SENSOR, rate, 1, {}, std::move(read), nullptr, nullptr});
+}
+
+DataflowGraph::NodeId DataflowGraph::addController(const std::string& name, double rate, size_t outputs,
+                                                   ControlFunction control) {
+    if (!control) {
+        throw std::invalid_argument("Controller node " + name + " needs a control function");
+    }
+    return addNode(Node{name, Kind::CONTROLLER, rate, outputs, {}, nullptr, std::move(control), nullptr});
+}
+
+DataflowGraph::NodeId DataflowGraph::addActuator(const std::string& name, double rate, SinkFunction write) {
+    return addNode(Node{name, Kind::ACTUATOR, rate, 0, {}, nullptr, nullptr, std::move(write)});
+}
+
+DataflowGraph::Node& DataflowGraph::node(NodeId id, Kind kind, const char* what) {
+    if (id >= nodes_.size() || nodes_[id].kind != kind) {
+        throw std::invalid_argument(std::string("Dataflow node ") + std::to_string(id) + " is not " + what);
+    }
+    return nodes_[id];
+}
+
+void DataflowGraph::connect(NodeId from, NodeId to, size_t output) {
+    if (from >= nodes_.size() || to >= nodes_.size()) {
+        throw std::invalid_argument("Dataflow edge references an unknown node");
+    }
+    if (output >= nodes_[from].outputs) {
+        throw std::invalid_argument("Dataflow node " + nodes_[from].name + " has no output " + std::to_string(output));
+    }
+    if (nodes_[to].kind == Kind::SENSOR) {
+        throw std::invalid_argument("Sensor node " + nodes_[to].name + " cannot take inputs");
+    }
+    nodes_[to].inputs.emplace_back(from, output);
+}
+
+void DataflowGraph::bindSensor(NodeId sensor, SourceFunction read) {
+    node(sensor, Kind::SENSOR, "a sensor").read = std::move(read);
+}
+
+void DataflowGraph::bindActuator(NodeId actuator, SinkFunction write) {
+    node(actuator, Kind::ACTUATOR, "an actuator").write = std::move(write);
+}
+
+DataflowSchedule DataflowGraph::compile() const {
+    const size_t count = nodes_.size();
+    std::vector<std::vector<NodeId>> consumers(count);
+    std::vector<size_t> parent(count);
+    std::iota(parent.begin(), parent.end(), 0);
+
+    for (NodeId id = 0; id < count; ++id) {
+        const Node& n = nodes_[id];
+        if (n.kind == Kind::SENSOR && !n.read) {
+            throw std::invalid_argument("Sensor node " + n.name + " is not bound to a source");
+        }
+        if (n.kind == Kind::ACTUATOR && !n.write) {
+            throw std::invalid_argument("Actuator node " + n.name + " is not bound to a sink");
+        }
+        if (n.kind == Kind::ACTUATOR && n.inputs.size() != 1) {
+            throw std::invalid_argument("Actuator node " + n.name + " needs exactly one input");
+        }
+        for (const auto& input : n.inputs) {
+            consumers[input.first].push_back(id);
+            parent[findRoot(parent, input.first)] = findRoot(parent, id);
+        }
+    }
+
+    // Kahn's algorithm, lowest id first so the order is deterministic
+    std::vector<size_t> pendingInputs(count);
+    std::vector<NodeId> ready;
+    for (NodeId id = 0; id < count; ++id) {
+        pendingInputs[id] = nodes_[id].inputs.size();
+        if (pendingInputs[id] == 0) {
+            ready.push_back(id);
+        }
+    }
+    std::vector<NodeId> order;
+    while (!ready.empty()) {
+        auto lowest = std::min_element(ready.begin(), ready.end());
+        NodeId id = *lowest;
+        ready.erase(lowest);
+        order.push_back(id);
+        for (NodeId consumer : consumers[id]) {
+            if (--pendingInputs[consumer] == 0) {
+                ready.push_back(consumer);
+            }
+        }
+    }
+    if (order.size() != count) {
+        std::string cycle;
+        for (NodeId id = 0; id < count; ++id) {
+            if (pendingInputs[id] > 0) {
+                cycle += (cycle.empty() ? "" : ", ") + nodes_[id].name;
+            }
+        }
+        throw std::invalid_argument("Dataflow graph has a cycle through: " + cycle);
+    }
+
+    // Branches are the weakly connected components, in order of first appearance
+    std::vector<size_t> branchOf(count);
+    std::vector<size_t> rootBranch(count, SIZE_MAX);
+    std::vector<std::vector<NodeId>> branchNodes;
+    for (NodeId id : order) {
+        size_t root = findRoot(parent, id);
+        if (rootBranch[root] == SIZE_MAX) {
+            rootBranch[root] = branchNodes.size();
+            branchNodes.emplace_back();
+        }
+        branchOf[id] = rootBranch[root];
+        branchNodes[branchOf[id]].push_back(id);
+    }
+
+    std::vector<double> branchRate(branchNodes.size(), 0.0);
+    for (NodeId id = 0; id < count; ++id) {
+        branchRate[branchOf[id]] = std::max(branchRate[branchOf[id]], nodes_[id].rate);
+    }
+    std::vector<uint32_t> divisor(count);
+    for (NodeId id = 0; id < count; ++id) {
+        double ratio = branchRate[branchOf[id]] / nodes_[id].rate;
+        divisor[id] = static_cast<uint32_t>(std::llround(ratio));
+        if (std::fabs(ratio - divisor[id]) > 1e-6 * ratio) {
+            throw std::invalid_argument("Rate of " + nodes_[id].name + " (" + std::to_string(nodes_[id].rate) +
+                                        " Hz) does not divide its branch rate (" +
+                                        std::to_string(branchRate[branchOf[id]]) + " Hz)");
+        }
+    }
+    for (NodeId id = 0; id < count; ++id) {
+        for (const auto& input : nodes_[id].inputs) {
+            uint32_t fast = std::min(divisor[id], divisor[input.first]);
+            uint32_t slow = std::max(divisor[id], divisor[input.first]);
+            if (slow % fast != 0) {
+                throw std::invalid_argument("Rate mismatch on " + nodes_[input.first].name + " -> " +
+                                            nodes_[id].name + ": " + std::to_string(nodes_[input.first].rate) +
+                                            " Hz and " + std::to_string(nodes_[id].rate) + " Hz are not harmonic");
+            }
+        }
+    }
+
+    // Lay out steps and buffers branch by branch in execution order; a
+    // node's gathered inputs sit right before its outputs
+    DataflowSchedule schedule;
+    schedule.outputSlots_.assign(count, 0);
+    std::vector<uint32_t> inputSlots(count, 0);
+    uint32_t slots = 0;
+    for (const auto& nodesInBranch : branchNodes) {
+        for (NodeId id : nodesInBranch) {
+            const Node& n = nodes_[id];
+            inputSlots[id] = slots;
+            slots += n.kind == Kind::CONTROLLER ? static_cast<uint32_t>(n.inputs.size()) : 0;
+            schedule.outputSlots_[id] = slots;
+            slots += static_cast<uint32_t>(n.outputs);
+        }
+    }
+    schedule.buffers_.resize(slots);
+
+    for (size_t b = 0; b < branchNodes.size(); ++b) {
+        DataflowSchedule::Branch branch;
+        branch.rate = branchRate[b];
+        branch.firstStep = schedule.steps_.size();
+        branch.stepCount = branchNodes[b].size();
+        for (NodeId id : branchNodes[b]) {
+            const Node& n = nodes_[id];
+            DataflowSchedule::Step step;
+            step.kind = n.kind;
+            step.node = id;
+            step.divisor = divisor[id];
+            step.gatherBegin = static_cast<uint32_t>(schedule.sources_.size());
+            step.inputSlot = inputSlots[id];
+            step.inputCount = static_cast<uint32_t>(n.inputs.size());
+            step.outputSlot = schedule.outputSlots_[id];
+            step.outputCount = static_cast<uint32_t>(n.outputs);
+            step.signal = n.kind == Kind::ACTUATOR ? SignalRegistry::instance().intern(n.name) : INVALID_SIGNAL;
+            for (const auto& input : n.inputs) {
+                schedule.sources_.push_back(schedule.outputSlots_[input.first] + static_cast<uint32_t>(input.second));
+            }
+            schedule.steps_.push_back(step);
+            schedule.reads_.push_back(n.read);
+            schedule.controls_.push_back(n.control);
+            schedule.writes_.push_back(n.write);
+        }
+        schedule.branches_.push_back(branch);
+    }
+    for (const auto& n : nodes_) {
+        schedule.names_.push_back(n.name);
+    }
+    return schedule;
+}
+
+void DataflowSchedule::runBranch(size_t branch, uint64_t cycle) {
+    const Branch& b = branches_.at(branch);
+    for (size_t i = b.firstStep; i < b.firstStep + b.stepCount; ++i) {
+        const Step& step = steps_[i];
+        if (cycle % step.divisor != 0) {
+            continue;
+        }
+        switch (step.kind) {
+            case DataflowGraph::Kind::SENSOR:
+                buffers_[step.outputSlot] = reads_[i]();
+                break;
+            case DataflowGraph::Kind::CONTROLLER:
+                for (uint32_t k = 0; k < step.inputCount; ++k) {
+                    buffers_[step.inputSlot + k] = buffers_[sources_[step.gatherBegin + k]];
+                }
+                controls_[i](Span<const SensorData>(buffers_.data() + step.inputSlot, step.inputCount),
+                             Span<SensorData>(buffers_.data() + step.outputSlot, step.outputCount));
+                break;
+            case DataflowGraph::Kind::ACTUATOR: {
+                const SensorData& input = buffers_[sources_[step.gatherBegin]];
+                writes_[i](ActuatorCommand(step.signal, input.value, input.unit));
+                break;
+            }
+        }
+    }
+}
+
+std::vector<std::string> DataflowSchedule::executionOrder(size_t branch) const {
+    const Branch& b = branches_.at(branch);
+    std::vector<std::string> order;
+    for (size_t i = b.firstStep; i < b.firstStep + b.stepCount; ++i) {
+        order.push_back(names_[steps_[i].node]);
+    }
+    return order;
+}
+
+const SensorData& DataflowSchedule::output(DataflowGraph::NodeId node, size_t index) const {
+    return buffers_.at(outputSlots_.at(node) + index);
+}
+
+} // namespace dcs
@@ -0,0 +1,64 @@
+#include <dcs/event_trigger.h>
+#include <algorithm>
+
+namespace dcs {
+
+EventTrigger::EventTrigger(const SensorBoard& board, std::vector<SignalId> signals, size_t quorum,
+                           std::chrono::nanoseconds minInterArrival)
+    : board_(board), quorum_(std::max<size_t>(quorum, 1)), minInterArrival_(minInterArrival) {
+    setSignals(std::move(signals));
+}
+
+void EventTrigger::setSignals(std::vector<SignalId> signals) {
+    std::vector<uint64_t> consumed(signals.size(), 0);
+    for (size_t i = 0; i < signals.size(); ++i) {
+        auto it = std::find(signals_.begin(), signals_.end(), signals[i]);
+        if (it != signals_.end()) {
+            consumed[i] = consumed_[static_cast<size_t>(it - signals_.begin())];
+        }
+    }
+    signals_ = std::move(signals);
+    consumed_ = std::move(consumed);
+}
+
+size_t EventTrigger::freshCount() const {
+    size_t fresh = 0;
+    for (size_t i = 0; i < signals_.size(); ++i) {
+        if (board_.version(signals_[i]) != consumed_[i]) {
+            fresh++;
+        }
+    }
+    return fresh;
+}
+
+bool EventTrigger::wait(std::chrono::nanoseconds timeout) {
+    int64_t deadline = WaitStrategy::nowNs() + timeout.count();
+
+    // Rate limit first: samples arriving meanwhile are still counted afterwards
+    int64_t earliest = lastFireNs_ + minInterArrival_.count();
+    if (minInterArrival_.count() > 0 && earliest > WaitStrategy::nowNs()) {
+        sleeper_.waitUntil(std::min(earliest, deadline));
+        if (earliest > deadline) {
+            return false;
+        }
+    }
+
+    size_t needed = std::min(quorum_, signals_.size());
+    while (true) {
+        // Read the counter before the versions so a publish in between wakes the wait
+        uint32_t seen = board_.updateCount();
+        if (needed > 0 && freshCount() >= needed) {
+            for (size_t i = 0; i < signals_.size(); ++i) {
+                consumed_[i] = board_.version(signals_[i]);
+            }
+            lastFireNs_ = WaitStrategy::nowNs();
+            return true;
+        }
+        if (WaitStrategy::nowNs() >= deadline) {
+            return false;
+        }
+        board_.waitForUpdate(signals_, seen, deadline);
+    }
+}
+
+} // namespace dcs
@@ -0,0 +1,226 @@
+#include <dcs/flight_recorder.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace dcs {
+
+namespace {
+
+constexpr uint64_t DUMP_MAGIC = 0x4443534652454331ULL; // "DCSFREC1"
+constexpr size_t NAME_BYTES = 44;
+
+// File layout: DumpHeader, channelCount NameEntry, recordCount FlightRecord,
+// signalCount NameEntry. Everything is fixed-size and native-endian.
+struct DumpHeader {
+    uint64_t magic;
+    uint32_t recordSize;
+    uint32_t channelCount;
+    uint32_t signalCount;
+    uint32_t reserved;
+    uint64_t recordCount;
+    int64_t dumpTimeNs;
+    char reason[64];
+};
+
+struct NameEntry {
+    uint32_t id;
+    char name[NAME_BYTES];
+};
+
+static_assert(sizeof(DumpHeader) == 104, "DumpHeader layout");
+static_assert(sizeof(NameEntry) == 48, "NameEntry layout");
+
+void copyName(char* dst, size_t size, const std::string& name) {
+    std::memset(dst, 0, size);
+    std::memcpy(dst, name.data(), std::min(name.size(), size - 1));
+}
+
+std::string readName(const char* src, size_t size) {
+    return std::string(src, strnlen(src, size));
+}
+
+} // namespace
+
+FlightRecorder::Channel::Channel(const std::string& name, uint16_t index, size_t capacity)
+    : index_(index), name_(name) {
+    // One spare slot: dump() skips the slot the writer may be overwriting
+    size_t size = 1;
+    while (size < capacity + 1) {
+        size <<= 1;
+    }
+    mask_ = size - 1;
+    records_.reset(new FlightRecord[size]());   // Value-initialized, so the pages are touched now
+}
+
+FlightRecorder::Channel* FlightRecorder::addChannel(const std::string& name, size_t records) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (channels_.size() > UINT16_MAX) {
+        throw FlightRecorderException("Too many flight recorder channels");
+    }
+    channels_.emplace_back(new Channel(name, static_cast<uint16_t>(channels_.size()), records));
+    return channels_.back().get();
+}
+
+size_t FlightRecorder::channelCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return channels_.size();
+}
+
+size_t FlightRecorder::dump(const std::string& path, const std::string& reason) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& registry = SignalRegistry::instance();
+
+    // Size for everything the rings could hold; shrunk to fit at the end
+    std::vector<uint64_t> heads(channels_.size());
+    size_t maxRecords = 0;
+    for (size_t c = 0; c < channels_.size(); ++c) {
+        heads[c] = channels_[c]->head_.load(std::memory_order_acquire);
+        maxRecords += static_cast<size_t>(std::min<uint64_t>(heads[c], channels_[c]->mask_ + 1));
+    }
+    size_t maxSignals = registry.size();
+    size_t recordsOffset = sizeof(DumpHeader) + channels_.size() * sizeof(NameEntry);
+    size_t maxSize = recordsOffset + maxRecords * sizeof(FlightRecord) + maxSignals * sizeof(NameEntry);
+
+    int fd = ::open(path.c_str(), O_CREAT | O_RDWR | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        throw FlightRecorderException("open failed for " + path + ": " + std::strerror(errno));
+    }
+    if (ftruncate(fd, static_cast<off_t>(maxSize)) != 0) {
+        int err = errno;
+        ::close(fd);
+        throw FlightRecorderException("ftruncate failed for " + path + ": " + std::strerror(err));
+    }
+    void* map = mmap(nullptr, maxSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED) {
+        int err = errno;
+        ::close(fd);
+        throw FlightRecorderException("mmap failed for " + path + ": " + std::strerror(err));
+    }
+    char* base = static_cast<char*>(map);
+
+    auto* channelNames = reinterpret_cast<NameEntry*>(base + sizeof(DumpHeader));
+    auto* records = reinterpret_cast<FlightRecord*>(base + recordsOffset);
+    size_t count = 0;
+    for (size_t c = 0; c < channels_.size(); ++c) {
+        const Channel& channel = *channels_[c];
+        channelNames[c].id = static_cast<uint32_t>(c);
+        copyName(channelNames[c].name, NAME_BYTES, channel.name_);
+
+        uint64_t capacity = channel.mask_ + 1;
+        uint64_t first = heads[c] > capacity ? heads[c] - capacity : 0;
+        FlightRecord* out = records + count;
+        for (uint64_t k = first; k < heads[c]; ++k) {
+            out[k - first] = channel.records_[k & channel.mask_];
+        }
+
+        // The writer kept going during the copy; the slot it may be writing
+        // now and everything before it in ring order may be torn
+        std::atomic_thread_fence(std::memory_order_acquire);
+        uint64_t head = channel.head_.load(std::memory_order_relaxed);
+        uint64_t firstIntact = head + 1 > capacity ? head + 1 - capacity : 0;
+        uint64_t skip = firstIntact > first ? std::min(firstIntact - first, heads[c] - first) : 0;
+        size_t kept = static_cast<size_t>(heads[c] - first - skip);
+        std::memmove(out, out + skip, kept * sizeof(FlightRecord));
+        count += kept;
+    }
+
+    // Oldest first across channels; stable keeps each cycle's records in order
+    std::stable_sort(records, records + count, [](const FlightRecord& a, const FlightRecord& b) {
+        return a.timestampNs < b.timestampNs;
+    });
+
+    std::vector<SignalId> signals;
+    for (size_t i = 0; i < count; ++i) {
+        if (records[i].signal != INVALID_SIGNAL) {
+            signals.push_back(records[i].signal);
+        }
+    }
+    std::sort(signals.begin(), signals.end());
+    signals.erase(std::unique(signals.begin(), signals.end()), signals.end());
+    auto* signalNames = reinterpret_cast<NameEntry*>(records + count);
+    size_t named = 0;
+    for (SignalId id : signals) {
+        if (named == maxSignals) {
+            break;
+        }
+        std::string name;
+        try {
+            name = registry.name(id);
+        } catch (const std::out_of_range&) {
+            continue;
+        }
+        signalNames[named].id = id;
+        copyName(signalNames[named].name, NAME_BYTES, name);
+        named++;
+    }
+
+    auto* header = reinterpret_cast<DumpHeader*>(base);
+    header->magic = DUMP_MAGIC;
+    header->recordSize = sizeof(FlightRecord);
+    header->channelCount = static_cast<uint32_t>(channels_.size());
+    header->signalCount = static_cast<uint32_t>(named);
+    header->reserved = 0;
+    header->recordCount = count;
+    header->dumpTimeNs = TscClock::now().time_since_epoch().count();
+    copyName(header->reason, sizeof(header->reason), reason);
+
+    size_t size = recordsOffset + count * sizeof(FlightRecord) + named * sizeof(NameEntry);
+    bool synced = msync(map, maxSize, MS_SYNC) == 0;
+    int err = errno;
+    munmap(map, maxSize);
+    if (synced && ftruncate(fd, static_cast<off_t>(size)) != 0) {
+        synced = false;
+        err = errno;
+    }
+    ::close(fd);
+    if (!synced) {
+        throw FlightRecorderException("writing " + path + " failed: " + std::strerror(err));
+    }
+    return count;
+}
+
+FlightDump FlightRecorder::load(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        throw FlightRecorderException("cannot open " + path);
+    }
+    std::vector<char> data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+    DumpHeader header;
+    if (data.size() < sizeof(header)) {
+        throw FlightRecorderException(path + " is not a flight recorder dump");
+    }
+    std::memcpy(&header, data.data(), sizeof(header));
+    size_t expected = sizeof(header) + header.channelCount * sizeof(NameEntry) +
+                      header.recordCount * sizeof(FlightRecord) + header.signalCount * sizeof(NameEntry);
+    if (header.magic != DUMP_MAGIC || header.recordSize != sizeof(FlightRecord) || data.size() != expected) {
+        throw FlightRecorderException(path + " is not a flight recorder dump");
+    }
+
+    FlightDump dump;
+    dump.reason = readName(header.reason, sizeof(header.reason));
+    dump.dumpTimeNs = header.dumpTimeNs;
+    const char* p = data.data() + sizeof(header);
+    for (uint32_t c = 0; c < header.channelCount; ++c, p += sizeof(NameEntry)) {
+        NameEntry entry;
+        std::memcpy(&entry, p, sizeof(entry));
+        dump.channels.push_back(readName(entry.name, NAME_BYTES));
+    }
+    dump.records.resize(header.recordCount);
+    std::memcpy(dump.records.data(), p, header.recordCount * sizeof(FlightRecord));
+    p += header.recordCount * sizeof(FlightRecord);
+    for (uint32_t s = 0; s < header.signalCount; ++s, p += sizeof(NameEntry)) {
+        NameEntry entry;
+        std::memcpy(&entry, p, sizeof(entry));
+        dump.signals[entry.id] = readName(entry.name, NAME_BYTES);
+    }
+    return dump;
+}
+
+} // namespace dcs
@@ -0,0 +1,44 @@
+#include <dcs/module.h>
+#include <stdexcept>
+
+namespace dcs {
+
+Module::Module(const std::string& name, const std::string& version)
+    : name_(name), version_(version) {}
+
+void Module::start() {
+    setState(ModuleState::RUNNING);
+}
+
+void Module::stop() {
+    if (state_ == ModuleState::RUNNING) {
+        setState(ModuleState::PAUSED);
+    }
+}
+
+void Module::shutdown() {
+    setState(ModuleState::SHUTDOWN);
+}
+
+void Module::setIPCHandles(std::shared_ptr<MessageQueue> mq, std::shared_ptr<SharedMemory> sm) {
+    messageQueue_ = std::move(mq);
+    sharedMemory_ = std::move(sm);
+}
+
+void SensorModule::setUpdateRate(double hz) {
+    if (!(hz > 0.0)) {
+        throw std::invalid_argument("Sensor " + name_ + " needs a positive update rate");
+    }
+    updateRate_ = hz;
+}
+
+bool ActuatorModule::isSafeToExecute(const ActuatorCommand& cmd) const {
+    return !emergencyStop_ && validateCommand(cmd);
+}
+
+bool ActuatorModule::validateCommand(const ActuatorCommand& cmd) const {
+    // NaN fails both comparisons
+    return cmd.value >= limits_.minValue && cmd.value <= limits_.maxValue;
+}
+
+} // namespace dcs
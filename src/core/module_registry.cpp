@@ -0,0 +1,574 @@
+#include <dcs/control_system.h>
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+
+namespace dcs {
+
+namespace {
+
+using CreateModuleFn = Module* (*)();
+using DestroyModuleFn = void (*)(Module*);
+
+std::chrono::microseconds since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+}
+
+size_t poolSize(size_t requested, size_t jobs) {
+    size_t threads = requested ? requested : std::max(1u, std::thread::hardware_concurrency());
+    return std::max<size_t>(1, std::min(threads, jobs));
+}
+
+// Run job(i, worker) for every i in [0, count) on up to `threads` workers
+template<typename Job>
+void parallelFor(size_t count, size_t threads, Job job) {
+    std::atomic<size_t> next{0};
+    std::vector<std::thread> workers;
+    size_t workerCount = poolSize(threads, count);
+    for (size_t w = 0; w < workerCount; ++w) {
+        workers.emplace_back([&, w]() {
+            for (size_t i = next++; i < count; i = next++) {
+                job(i, w);
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+// dlopen a module library. The returned module owns the library: its deleter
+// runs destroyModule and only then dlclose()s, so the code backing a module can
+// never be unmapped while any reference (or deferred retire) to it remains.
+std::shared_ptr<Module> openModuleLibrary(const std::string& path, void*& libraryHandle, std::string& error) {
+    void* handle = dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL);
+    if (!handle) {
+        const char* err = dlerror();
+        error = err ? err : "dlopen failed";
+        return nullptr;
+    }
+    auto create = reinterpret_cast<CreateModuleFn>(dlsym(handle, "createModule"));
+    auto destroy = reinterpret_cast<DestroyModuleFn>(dlsym(handle, "destroyModule"));
+    Module* raw = create && destroy ? create() : nullptr;
+    if (!raw) {
+        error = "Library does not export a DCS module";
+        dlclose(handle);
+        return nullptr;
+    }
+    libraryHandle = handle;
+    return std::shared_ptr<Module>(raw, [destroy, handle](Module* module) {
+        destroy(module);
+        dlclose(handle);
+    });
+}
+
+} // namespace
+
+struct ControlSystem::PendingModule {
+    std::shared_ptr<Module> module;
+    void* libraryHandle{nullptr};
+    ModuleStartupRecord record;
+};
+
+bool ControlSystem::loadModule(const std::string& libraryPath) {
+    return loadModules({libraryPath}, 1).success;
+}
+
+bool ControlSystem::unloadModule(const std::string& moduleName) {
+    if (EpochDomain::instance().inReadSection()) {
+        throw std::logic_error("Cannot unload module " + moduleName + " inside an EpochGuard");
+    }
+    std::shared_ptr<Module> module;
+    {
+        std::lock_guard<std::mutex> lock(modulesMutex_);
+        if (deferredModules_.erase(moduleName)) {
+            return true;    // Never loaded, nothing to tear down
+        }
+        auto it = modules_.find(moduleName);
+        if (it == modules_.end()) {
+            return false;
+        }
+        ModuleInfo& info = it->second;
+        if (info.handle.isValid()) {
+            moduleTable_.erase(info.handle);  // Loop handles resolve to nullptr from here on
+        }
+        if (info.watch != INVALID_WATCH) {
+            watchdog_.unwatch(info.watch);
+        }
+        module = std::move(info.module);
+        modules_.erase(it);
+    }
+    // Same grace period as a hot swap: cycles still holding the module finish first
+    EpochDomain::instance().retire([module]() {
+        if (module->getState() == ModuleState::RUNNING) {
+            module->stop();
+        }
+        module->shutdown();
+    });
+    EpochDomain::instance().synchronize();
+    return true;
+}
+
+std::vector<std::string> ControlSystem::getLoadedModules() const {
+    std::lock_guard<std::mutex> lock(modulesMutex_);
+    std::vector<std::string> names;
+    names.reserve(modules_.size());
+    for (const auto& entry : modules_) {
+        names.push_back(entry.first);
+    }
+    std::sort(names.begin(), names.end());
+    return names;
+}
+
+ModuleLoadReport ControlSystem::loadModules(const std::vector<std::string>& libraryPaths, size_t threads) {
+    auto batchStart = std::chrono::steady_clock::now();
+    ModuleLoadReport report;
+    std::vector<PendingModule> pending(libraryPaths.size());
+
+    // dlopen and construct every module in parallel; construction is cheap,
+    // the expensive part is initialize() which runs in dependency order below
+    parallelFor(libraryPaths.size(), threads, [&](size_t i, size_t w) {
+        PendingModule& entry = pending[i];
+        entry.record.libraryPath = libraryPaths[i];
+        entry.record.worker = w;
+        entry.record.loadStart = since(batchStart);
+
+        entry.module = openModuleLibrary(libraryPaths[i], entry.libraryHandle, entry.record.error);
+        if (entry.module) {
+            entry.record.name = entry.module->getName();
+        }
+        entry.record.loadEnd = since(batchStart);
+    });
+
+    initializeBatch(pending, threads, batchStart, report);
+    rebindLoops(report);
+    return report;
+}
+
+void ControlSystem::deferModule(const std::string& name, const std::string& libraryPath) {
+    std::lock_guard<std::mutex> lock(modulesMutex_);
+    if (modules_.count(name) || deferredModules_.count(name)) {
+        throw ControlSystemException("Module already registered: " + name);
+    }
+    deferredModules_[name] = DeferredModule{libraryPath, nullptr};
+}
+
+void ControlSystem::deferModule(const std::string& name, std::function<std::shared_ptr<Module>()> factory) {
+    if (!factory) {
+        throw std::invalid_argument("Deferred module " + name + " needs a factory");
+    }
+    std::lock_guard<std::mutex> lock(modulesMutex_);
+    if (modules_.count(name) || deferredModules_.count(name)) {
+        throw ControlSystemException("Module already registered: " + name);
+    }
+    deferredModules_[name] = DeferredModule{"", std::move(factory)};
+}
+
+// Opens the requested modules wave by wave, each wave adding the deferred
+// dependencies of the last, then initializes them all as one batch
+ModuleLoadReport ControlSystem::loadDeferredModules(const std::vector<std::string>& names, size_t threads) {
+    auto batchStart = std::chrono::steady_clock::now();
+    ModuleLoadReport report;
+    std::lock_guard<std::mutex> serial(deferredLoadMutex_);
+
+    std::vector<PendingModule> pending;
+    std::vector<std::string> wave = names;
+    if (wave.empty()) {
+        std::lock_guard<std::mutex> lock(modulesMutex_);
+        for (const auto& entry : deferredModules_) {
+            wave.push_back(entry.first);
+        }
+    }
+    while (!wave.empty()) {
+        std::vector<std::pair<std::string, DeferredModule>> taken;
+        {
+            std::lock_guard<std::mutex> lock(modulesMutex_);
+            for (const auto& name : wave) {
+                auto it = deferredModules_.find(name);
+                if (it != deferredModules_.end()) {
+                    taken.emplace_back(it->first, std::move(it->second));
+                    deferredModules_.erase(it);
+                }
+            }
+        }
+        size_t first = pending.size();
+        pending.resize(first + taken.size());
+        parallelFor(taken.size(), threads, [&](size_t i, size_t w) {
+            PendingModule& entry = pending[first + i];
+            const auto& source = taken[i].second;
+            entry.record.name = taken[i].first;
+            entry.record.libraryPath = source.libraryPath;
+            entry.record.worker = w;
+            entry.record.loadStart = since(batchStart);
+            if (source.factory) {
+                try {
+                    entry.module = source.factory();
+                } catch (const std::exception& e) {
+                    entry.record.error = e.what();
+                }
+            } else {
+                entry.module = openModuleLibrary(source.libraryPath, entry.libraryHandle, entry.record.error);
+            }
+            if (entry.module && entry.module->getName() != entry.record.name) {
+                entry.record.error = "Deferred as " + entry.record.name + " but is " + entry.module->getName();
+                entry.module.reset();
+            } else if (!entry.module && entry.record.error.empty()) {
+                entry.record.error = "Null module";
+            }
+            entry.record.loadEnd = since(batchStart);
+        });
+
+        wave.clear();
+        for (size_t i = first; i < pending.size(); ++i) {
+            if (pending[i].module) {
+                for (const auto& dep : pending[i].module->getDependencies()) {
+                    wave.push_back(dep);
+                }
+            }
+        }
+    }
+
+    initializeBatch(pending, threads, batchStart, report);
+    // Loaded on first use by a running system: join it
+    if (running_) {
+        for (auto& entry : pending) {
+            if (entry.record.success && entry.module->getState() == ModuleState::READY) {
+                entry.module->start();
+            }
+        }
+    }
+    return report;
+}
+
+void ControlSystem::loadIfDeferred(const std::string& name) {
+    {
+        std::lock_guard<std::mutex> lock(modulesMutex_);
+        if (!deferredModules_.count(name)) {
+            return;
+        }
+    }
+    loadDeferredModules({name});   // Failures go to the error callback
+}
+
+ModuleLoadReport ControlSystem::addModules(const std::vector<std::shared_ptr<Module>>& modules, size_t threads) {
+    auto batchStart = std::chrono::steady_clock::now();
+    ModuleLoadReport report;
+    std::vector<PendingModule> pending(modules.size());
+    for (size_t i = 0; i < modules.size(); ++i) {
+        pending[i].module = modules[i];
+        if (modules[i]) {
+            pending[i].record.name = modules[i]->getName();
+        } else {
+            pending[i].record.error = "Null module";
+        }
+    }
+    initializeBatch(pending, threads, batchStart, report);
+    rebindLoops(report);
+    return report;
+}
+
+// Kahn's algorithm over the batch: a module becomes ready when all of its
+// in-batch dependencies initialized successfully. Dependencies outside the
+// batch must already be loaded. Failures propagate to dependents.
+void ControlSystem::initializeBatch(std::vector<PendingModule>& pending, size_t threads,
+                                    std::chrono::steady_clock::time_point batchStart,
+                                    ModuleLoadReport& report) {
+    const size_t count = pending.size();
+    std::unordered_map<std::string, size_t> byName;
+    for (size_t i = 0; i < count; ++i) {
+        if (pending[i].module && !byName.emplace(pending[i].record.name, i).second) {
+            pending[i].record.error = "Duplicate module name in batch: " + pending[i].record.name;
+            pending[i].module.reset();
+        }
+    }
+
+    std::vector<std::vector<size_t>> dependents(count);
+    std::vector<size_t> waitingOn(count, 0);
+    std::deque<size_t> ready;
+    std::vector<bool> done(count, false);
+
+    {
+        std::lock_guard<std::mutex> lock(modulesMutex_);
+        for (size_t i = 0; i < count; ++i) {
+            if (!pending[i].module) {
+                done[i] = true;
+                continue;
+            }
+            if (modules_.count(pending[i].record.name)) {
+                pending[i].record.error = "Module already loaded: " + pending[i].record.name;
+                done[i] = true;
+                continue;
+            }
+            for (const auto& dep : pending[i].module->getDependencies()) {
+                auto it = byName.find(dep);
+                if (it != byName.end() && it->second != i) {
+                    dependents[it->second].push_back(i);
+                    waitingOn[i]++;
+                } else if (!modules_.count(dep)) {
+                    pending[i].record.error = "Missing dependency: " + dep;
+                }
+            }
+        }
+    }
+    // Modules that already failed release their dependents as failures
+    std::vector<size_t> failedRoots;
+    for (size_t i = 0; i < count; ++i) {
+        if (!pending[i].record.error.empty()) {
+            done[i] = true;
+            failedRoots.push_back(i);
+        } else if (waitingOn[i] == 0) {
+            ready.push_back(i);
+        }
+    }
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    size_t finished = 0;
+    size_t inFlight = 0;
+
+    // Called with mutex held
+    std::function<void(size_t, bool)> complete = [&](size_t index, bool ok) {
+        finished++;
+        for (size_t dependent : dependents[index]) {
+            if (done[dependent]) {
+                continue;
+            }
+            if (!ok) {
+                pending[dependent].record.error = "Dependency failed: " + pending[index].record.name;
+                done[dependent] = true;
+                complete(dependent, false);
+            } else if (--waitingOn[dependent] == 0) {
+                ready.push_back(dependent);
+            }
+        }
+    };
+    for (size_t index : failedRoots) {
+        complete(index, false);
+    }
+
+    auto worker = [&](size_t w) {
+        std::unique_lock<std::mutex> lock(mutex);
+        for (;;) {
+            cv.wait(lock, [&]() { return !ready.empty() || finished == count || inFlight == 0; });
+            if (ready.empty()) {
+                if (finished < count && inFlight == 0) {
+                    // Nothing running and nothing ready: the rest wait on each other
+                    for (size_t i = 0; i < count; ++i) {
+                        if (!done[i]) {
+                            pending[i].record.error = "Dependency cycle involving " + pending[i].record.name;
+                            done[i] = true;
+                            finished++;
+                        }
+                    }
+                    cv.notify_all();
+                }
+                if (finished == count) {
+                    return;
+                }
+                continue;
+            }
+            size_t index = ready.front();
+            ready.pop_front();
+            inFlight++;
+            lock.unlock();
+
+            PendingModule& entry = pending[index];
+            entry.record.worker = w;
+            entry.record.initStart = since(batchStart);
+            bool ok = true;
+            try {
+                if (!validateModuleCompatibility(entry.module.get())) {
+                    throw ModuleLoadException("Incompatible module version " + entry.module->getVersion());
+                }
+                entry.module->setIPCHandles(messageQueue_, sharedMemory_);
+                if (auto* sensor = dynamic_cast<SensorModule*>(entry.module.get())) {
+                    sensor->attachSensorBoard(sensorBoard_);
+                }
+                entry.module->initialize();
+            } catch (const std::exception& e) {
+                entry.record.error = e.what();
+                ok = false;
+            }
+            entry.record.initEnd = since(batchStart);
+            entry.record.success = ok;
+
+            lock.lock();
+            inFlight--;
+            done[index] = true;
+            complete(index, ok);
+            cv.notify_all();
+        }
+    };
+
+    std::vector<std::thread> workers;
+    size_t workerCount = finished == count ? 0 : poolSize(threads, count);
+    for (size_t w = 0; w < workerCount; ++w) {
+        workers.emplace_back(worker, w);
+    }
+    for (auto& thread : workers) {
+        thread.join();
+    }
+
+    // Publish the successful modules, release the rest
+    report.success = true;
+    {
+        std::lock_guard<std::mutex> lock(modulesMutex_);
+        for (auto& entry : pending) {
+            if (entry.record.success) {
+                deferredModules_.erase(entry.record.name);  // Loaded eagerly after all
+                ModuleInfo& info = modules_[entry.record.name];
+                info = ModuleInfo{entry.module, entry.libraryHandle, entry.record.libraryPath,
+                                  ModuleHandle<Module>{}, INVALID_WATCH};
+                watchModule(info, entry.module->getHeartbeatTimeout());
+            }
+        }
+    }
+    for (auto& entry : pending) {
+        if (!entry.record.success) {
+            report.success = false;
+            handleError(entry.record.name.empty() ? entry.record.libraryPath : entry.record.name,
+                        entry.record.error);
+            entry.module.reset();     // Also closes the library
+        }
+        report.modules.push_back(std::move(entry.record));
+    }
+    report.totalTime = since(batchStart);
+}
+
+bool ControlSystem::replaceModule(const std::string& name, const std::string& newLibraryPath) {
+    PendingModule entry;
+    entry.record.libraryPath = newLibraryPath;
+    entry.module = openModuleLibrary(newLibraryPath, entry.libraryHandle, entry.record.error);
+    if (!entry.module) {
+        handleError(name, "Hot swap failed: " + entry.record.error);
+        return false;
+    }
+    return swapModule(name, entry);
+}
+
+bool ControlSystem::replaceModule(const std::string& name, std::shared_ptr<Module> replacement) {
+    PendingModule entry;
+    entry.module = std::move(replacement);
+    if (!entry.module) {
+        handleError(name, "Hot swap failed: null module");
+        return false;
+    }
+    return swapModule(name, entry);
+}
+
+// Loop threads reach modules through moduleTable_ inside an EpochGuard, so the
+// swap is a single release store into the module's slot: a cycle sees either
+// the old module or the new one, never a mix, and never waits. Everything slow
+// (dlopen, initialize, state handoff) happens before the swap; everything
+// destructive (stop, shutdown, destroy, dlclose) after the grace period.
+bool ControlSystem::swapModule(const std::string& name, PendingModule& entry) {
+    if (EpochDomain::instance().inReadSection()) {
+        throw std::logic_error("Cannot replace module " + name + " inside an EpochGuard");
+    }
+    std::shared_ptr<Module> previous;
+    {
+        std::lock_guard<std::mutex> lock(modulesMutex_);
+        auto it = modules_.find(name);
+        if (it != modules_.end()) {
+            previous = it->second.module;
+        }
+    }
+
+    auto isSensor = [](const Module* m) { return dynamic_cast<const SensorModule*>(m) != nullptr; };
+    auto isActuator = [](const Module* m) { return dynamic_cast<const ActuatorModule*>(m) != nullptr; };
+    try {
+        if (!previous) {
+            throw ModuleLoadException("Module not loaded");
+        }
+        if (entry.module->getName() != name) {
+            throw ModuleLoadException("Replacement is named " + entry.module->getName());
+        }
+        // Live handles keep pointing at the slot, so the kind of module must match
+        if (isSensor(entry.module.get()) != isSensor(previous.get()) ||
+            isActuator(entry.module.get()) != isActuator(previous.get())) {
+            throw ModuleLoadException("Replacement is a different kind of module");
+        }
+        if (!validateModuleCompatibility(entry.module.get())) {
+            throw ModuleLoadException("Incompatible module version " + entry.module->getVersion());
+        }
+        entry.module->setIPCHandles(messageQueue_, sharedMemory_);
+        if (auto* sensor = dynamic_cast<SensorModule*>(entry.module.get())) {
+            sensor->attachSensorBoard(sensorBoard_);
+        }
+        entry.module->initialize();
+        entry.module->adoptState(*previous);
+        if (previous->getState() == ModuleState::RUNNING) {
+            entry.module->start();
+        }
+    } catch (const std::exception& e) {
+        handleError(name, std::string("Hot swap failed: ") + e.what());
+        return false;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(modulesMutex_);
+        auto it = modules_.find(name);
+        if (it == modules_.end() || it->second.module != previous) {
+            // Unloaded or replaced by someone else while we were initializing
+            entry.module->shutdown();
+            handleError(name, "Hot swap failed: module changed during swap");
+            return false;
+        }
+        ModuleInfo& info = it->second;
+        // The replacement inherits the watch; its beats count from the swap on
+        entry.module->heartbeat_ = previous->heartbeat_;
+        entry.module->heartbeat();
+        if (info.handle.isValid()) {
+            info.handle = moduleTable_.replace(info.handle, entry.module);
+        }
+        info.module = entry.module;
+        info.libraryHandle = entry.libraryHandle;
+        info.libraryPath = entry.record.libraryPath;
+    }
+
+    // Cycles already inside their EpochGuard may still be calling into the old
+    // module; quiesce it once they are done. Dropping the last reference then
+    // destroys it and, for library modules, closes the old library. The wait
+    // is on this thread, never a loop's; nothing else would reclaim it once
+    // those cycles have left.
+    EpochDomain::instance().retire([previous]() {
+        if (previous->getState() == ModuleState::RUNNING) {
+            previous->stop();
+        }
+        previous->shutdown();
+    });
+    EpochDomain::instance().synchronize();
+    return true;
+}
+
+void ControlSystem::setModuleTimeout(const std::string& moduleName, std::chrono::microseconds timeout) {
+    std::lock_guard<std::mutex> lock(modulesMutex_);
+    auto it = modules_.find(moduleName);
+    if (it == modules_.end()) {
+        throw ControlSystemException("Unknown module: " + moduleName);
+    }
+    watchModule(it->second, timeout);
+}
+
+// Called with modulesMutex_ held. Every module gets a watch before it is
+// published, disarmed until the system runs, so its Heartbeat never changes
+// under a running loop; later timeouts only re-arm it.
+void ControlSystem::watchModule(ModuleInfo& info, std::chrono::microseconds timeout) {
+    if (info.watch == INVALID_WATCH) {
+        info.watch = watchdog_.watch(info.module->getName(), std::chrono::microseconds(0),
+                                     [this](WatchId, const std::string& name, uint64_t missed) {
+                                         onWatchdogExpiry(name, missed);
+                                     });
+        info.module->heartbeat_ = watchdog_.heartbeat(info.watch);
+    }
+    info.watchTimeout = timeout;
+    if (running_) {
+        info.module->heartbeat();
+        watchdog_.setTimeout(info.watch, timeout);
+        if (timeout.count() > 0) {
+            reportRealtime(watchdog_.start());
+        }
+    }
+}
+
+} // namespace dcs
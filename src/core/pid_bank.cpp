@@ -0,0 +1,259 @@
+#include <dcs/pid_bank.h>
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define DCS_PID_X86 1
+#endif
+
+// No FMA contraction in the update paths: a fused multiply-add in one path
+// but not another would break bit-exactness between them. CMakeLists.txt
+// also builds this file with -ffp-contract=off; the pragma and attributes
+// keep that true for any other build.
+#if defined(__clang__)
+#pragma STDC FP_CONTRACT OFF
+#define DCS_NO_FP_CONTRACT
+#elif defined(__GNUC__)
+#define DCS_NO_FP_CONTRACT __attribute__((optimize("fp-contract=off")))
+#else
+#define DCS_NO_FP_CONTRACT
+#endif
+
+namespace dcs {
+
+namespace {
+
+// One contiguous run of controllers, as pointers into the bank's arrays
+struct Lanes {
+    const double* setpoint;
+    const double* measurement;
+    double* output;
+    const double* kp;
+    const double* ki;
+    const double* kd;
+    const double* integralMin;
+    const double* integralMax;
+    const double* alpha;
+    const double* outputMin;
+    const double* outputMax;
+    double* integral;
+    double* lastError;
+    double* lastDerivative;
+};
+
+// The reference algorithm; the vector paths below mirror it operation for operation
+DCS_NO_FP_CONTRACT void updateScalar(const Lanes& l, size_t begin, size_t end, double dt) {
+    for (size_t i = begin; i < end; ++i) {
+        double error = l.setpoint[i] - l.measurement[i];
+
+        // Proportional term
+        double p = l.kp[i] * error;
+
+        // Integral term with anti-windup
+        l.integral[i] += error * dt;
+        l.integral[i] = std::clamp(l.integral[i], l.integralMin[i], l.integralMax[i]);
+        double integralTerm = l.ki[i] * l.integral[i];
+
+        // Derivative term with filtering
+        double derivative = (error - l.lastError[i]) / dt;
+        derivative = l.alpha[i] * derivative + (1 - l.alpha[i]) * l.lastDerivative[i];
+        double d = l.kd[i] * derivative;
+
+        l.lastError[i] = error;
+        l.lastDerivative[i] = derivative;
+
+        l.output[i] = std::clamp(p + integralTerm + d, l.outputMin[i], l.outputMax[i]);
+    }
+}
+
+#ifdef DCS_PID_X86
+
+// std::clamp(v, lo, hi) is v < lo ? lo : hi < v ? hi : v; blends reproduce it
+// exactly, including NaN passing through and the sign of zero, where
+// min/max instructions would not
+DCS_NO_FP_CONTRACT __attribute__((target("avx2"))) inline __m256d clamp4(__m256d v, __m256d lo, __m256d hi) {
+    __m256d r = _mm256_blendv_pd(v, hi, _mm256_cmp_pd(hi, v, _CMP_LT_OQ));
+    return _mm256_blendv_pd(r, lo, _mm256_cmp_pd(v, lo, _CMP_LT_OQ));
+}
+
+// Returns the first index left for the scalar tail
+DCS_NO_FP_CONTRACT __attribute__((target("avx2"))) size_t updateAvx2(const Lanes& l, size_t count, double dt) {
+    const __m256d dtv = _mm256_set1_pd(dt);
+    const __m256d one = _mm256_set1_pd(1.0);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m256d error = _mm256_sub_pd(_mm256_loadu_pd(l.setpoint + i), _mm256_loadu_pd(l.measurement + i));
+        __m256d p = _mm256_mul_pd(_mm256_loadu_pd(l.kp + i), error);
+
+        __m256d integral = _mm256_add_pd(_mm256_loadu_pd(l.integral + i), _mm256_mul_pd(error, dtv));
+        integral = clamp4(integral, _mm256_loadu_pd(l.integralMin + i), _mm256_loadu_pd(l.integralMax + i));
+        __m256d integralTerm = _mm256_mul_pd(_mm256_loadu_pd(l.ki + i), integral);
+
+        __m256d alpha = _mm256_loadu_pd(l.alpha + i);
+        __m256d derivative = _mm256_div_pd(_mm256_sub_pd(error, _mm256_loadu_pd(l.lastError + i)), dtv);
+        derivative = _mm256_add_pd(_mm256_mul_pd(alpha, derivative),
+                                   _mm256_mul_pd(_mm256_sub_pd(one, alpha), _mm256_loadu_pd(l.lastDerivative + i)));
+        __m256d d = _mm256_mul_pd(_mm256_loadu_pd(l.kd + i), derivative);
+
+        _mm256_storeu_pd(l.integral + i, integral);
+        _mm256_storeu_pd(l.lastError + i, error);
+        _mm256_storeu_pd(l.lastDerivative + i, derivative);
+
+        __m256d output = _mm256_add_pd(_mm256_add_pd(p, integralTerm), d);
+        _mm256_storeu_pd(l.output + i,
+                         clamp4(output, _mm256_loadu_pd(l.outputMin + i), _mm256_loadu_pd(l.outputMax + i)));
+    }
+    return i;
+}
+
+DCS_NO_FP_CONTRACT __attribute__((target("avx512f"))) inline __m512d clamp8(__m512d v, __m512d lo, __m512d hi) {
+    __m512d r = _mm512_mask_blend_pd(_mm512_cmp_pd_mask(hi, v, _CMP_LT_OQ), v, hi);
+    return _mm512_mask_blend_pd(_mm512_cmp_pd_mask(v, lo, _CMP_LT_OQ), r, lo);
+}
+
+DCS_NO_FP_CONTRACT __attribute__((target("avx512f"))) size_t updateAvx512(const Lanes& l, size_t count, double dt) {
+    const __m512d dtv = _mm512_set1_pd(dt);
+    const __m512d one = _mm512_set1_pd(1.0);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m512d error = _mm512_sub_pd(_mm512_loadu_pd(l.setpoint + i), _mm512_loadu_pd(l.measurement + i));
+        __m512d p = _mm512_mul_pd(_mm512_loadu_pd(l.kp + i), error);
+
+        __m512d integral = _mm512_add_pd(_mm512_loadu_pd(l.integral + i), _mm512_mul_pd(error, dtv));
+        integral = clamp8(integral, _mm512_loadu_pd(l.integralMin + i), _mm512_loadu_pd(l.integralMax + i));
+        __m512d integralTerm = _mm512_mul_pd(_mm512_loadu_pd(l.ki + i), integral);
+
+        __m512d alpha = _mm512_loadu_pd(l.alpha + i);
+        __m512d derivative = _mm512_div_pd(_mm512_sub_pd(error, _mm512_loadu_pd(l.lastError + i)), dtv);
+        derivative = _mm512_add_pd(_mm512_mul_pd(alpha, derivative),
+                                   _mm512_mul_pd(_mm512_sub_pd(one, alpha), _mm512_loadu_pd(l.lastDerivative + i)));
+        __m512d d = _mm512_mul_pd(_mm512_loadu_pd(l.kd + i), derivative);
+
+        _mm512_storeu_pd(l.integral + i, integral);
+        _mm512_storeu_pd(l.lastError + i, error);
+        _mm512_storeu_pd(l.lastDerivative + i, derivative);
+
+        __m512d output = _mm512_add_pd(_mm512_add_pd(p, integralTerm), d);
+        _mm512_storeu_pd(l.output + i,
+                         clamp8(output, _mm512_loadu_pd(l.outputMin + i), _mm512_loadu_pd(l.outputMax + i)));
+    }
+    return i;
+}
+
+#endif // DCS_PID_X86
+
+} // namespace
+
+PidController::PidController(double kp, double ki, double kd) {
+    gains_.kp = kp;
+    gains_.ki = ki;
+    gains_.kd = kd;
+}
+
+double PidController::calculate(double setpoint, double measurement, double dt) {
+    double integralMin = -gains_.integralLimit;
+    double output;
+    Lanes lane{&setpoint, &measurement, &output,
+               &gains_.kp, &gains_.ki, &gains_.kd,
+               &integralMin, &gains_.integralLimit, &gains_.alpha,
+               &gains_.outputMin, &gains_.outputMax,
+               &integral_, &lastError_, &lastDerivative_};
+    updateScalar(lane, 0, 1, dt);
+    return output;
+}
+
+void PidController::reset() {
+    integral_ = 0.0;
+    lastError_ = 0.0;
+    lastDerivative_ = 0.0;
+}
+
+size_t PidBank::add(const PidGains& gains) {
+    for (auto* array : {&kp_, &ki_, &kd_, &integralMin_, &integralMax_, &alpha_, &outputMin_, &outputMax_,
+                        &integral_, &lastError_, &lastDerivative_}) {
+        array->push_back(0.0);
+    }
+    setGains(size() - 1, gains);
+    return size() - 1;
+}
+
+void PidBank::reserve(size_t count) {
+    for (auto* array : {&kp_, &ki_, &kd_, &integralMin_, &integralMax_, &alpha_, &outputMin_, &outputMax_,
+                        &integral_, &lastError_, &lastDerivative_}) {
+        array->reserve(count);
+    }
+}
+
+void PidBank::setGains(size_t index, const PidGains& gains) {
+    kp_.at(index) = gains.kp;
+    ki_[index] = gains.ki;
+    kd_[index] = gains.kd;
+    integralMin_[index] = -gains.integralLimit;
+    integralMax_[index] = gains.integralLimit;
+    alpha_[index] = gains.alpha;
+    outputMin_[index] = gains.outputMin;
+    outputMax_[index] = gains.outputMax;
+}
+
+PidGains PidBank::gains(size_t index) const {
+    PidGains gains;
+    gains.kp = kp_.at(index);
+    gains.ki = ki_[index];
+    gains.kd = kd_[index];
+    gains.integralLimit = integralMax_[index];
+    gains.alpha = alpha_[index];
+    gains.outputMin = outputMin_[index];
+    gains.outputMax = outputMax_[index];
+    return gains;
+}
+
+void PidBank::reset(size_t index) {
+    integral_.at(index) = 0.0;
+    lastError_[index] = 0.0;
+    lastDerivative_[index] = 0.0;
+}
+
+void PidBank::reset() {
+    std::fill(integral_.begin(), integral_.end(), 0.0);
+    std::fill(lastError_.begin(), lastError_.end(), 0.0);
+    std::fill(lastDerivative_.begin(), lastDerivative_.end(), 0.0);
+}
+
+void PidBank::update(Span<const double> setpoints, Span<const double> measurements, double dt,
+                     Span<double> outputs) {
+    const size_t count = size();
+    if (setpoints.size() != count || measurements.size() != count || outputs.size() != count) {
+        throw std::invalid_argument("PidBank::update needs " + std::to_string(count) + " setpoints, "
+                                    "measurements and outputs");
+    }
+    Lanes lanes{setpoints.data(), measurements.data(), outputs.data(),
+                kp_.data(), ki_.data(), kd_.data(),
+                integralMin_.data(), integralMax_.data(), alpha_.data(),
+                outputMin_.data(), outputMax_.data(),
+                integral_.data(), lastError_.data(), lastDerivative_.data()};
+
+    size_t done = 0;
+#ifdef DCS_PID_X86
+    if (isa_ == Isa::AVX512) {
+        done = updateAvx512(lanes, count, dt);
+    } else if (isa_ == Isa::AVX2) {
+        done = updateAvx2(lanes, count, dt);
+    }
+#endif
+    updateScalar(lanes, done, count, dt);
+}
+
+PidBank::Isa PidBank::bestIsa() {
+    return simdLevel();
+}
+
+void PidBank::setIsa(Isa isa) {
+    if (static_cast<int>(isa) > static_cast<int>(bestIsa())) {
+        throw std::invalid_argument("Instruction set not supported by this CPU");
+    }
+    isa_ = isa;
+}
+
+} // namespace dcs
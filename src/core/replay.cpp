@@ -0,0 +1,521 @@
+#include <dcs/replay.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace dcs {
+
+namespace {
+
+constexpr uint64_t REPLAY_MAGIC = 0x4443535245504C31ULL; // "DCSREPL1"
+constexpr uint32_t REPLAY_VERSION = 1;
+constexpr size_t FLUSH_BYTES = 1 << 20;                  // Wake the writer at this much pending data
+constexpr auto FLUSH_INTERVAL = std::chrono::milliseconds(50);
+constexpr size_t READ_BUFFER_BYTES = 1 << 20;
+constexpr uint32_t MAX_FRAME_BYTES = 64u << 20;
+
+// File layout: FileHeader, then the loop, sensor and actuator names as
+// length-prefixed strings, then frames until the end of the file. A SIGNAL
+// frame names a SignalId before its first use; a CYCLE frame is a
+// CycleRecord, its samples and its commands. Everything is native-endian.
+struct FileHeader {
+    uint64_t magic;
+    uint32_t version;
+    uint32_t sensorCount;
+    uint32_t actuatorCount;
+    uint32_t reserved;
+    double frequency;
+};
+
+enum FrameType : uint32_t {
+    SIGNAL_FRAME = 1,
+    CYCLE_FRAME = 2
+};
+
+struct FrameHeader {
+    uint32_t type;
+    uint32_t size;      // Bytes that follow
+};
+
+struct CycleRecord {
+    uint64_t cycle;
+    int64_t timestampNs;
+    uint32_t sampleCount;
+    uint32_t commandCount;
+    uint32_t flags;
+    uint32_t reserved;
+};
+
+constexpr uint32_t CONTROL_FAILED = 1;
+
+// Followed by the vector components, padded to 8 bytes
+struct SampleRecord {
+    int64_t timestampNs;
+    double value;
+    SignalId id;
+    uint8_t unit;
+    uint8_t kind;
+    uint8_t components;
+    uint8_t reserved;
+};
+
+struct CommandRecord {
+    double value;
+    SignalId id;
+    uint32_t unit;
+};
+
+static_assert(sizeof(FileHeader) == 32, "FileHeader layout");
+static_assert(sizeof(CycleRecord) == 32, "CycleRecord layout");
+static_assert(sizeof(SampleRecord) == 24, "SampleRecord layout");
+static_assert(sizeof(CommandRecord) == 16, "CommandRecord layout");
+
+size_t componentBytes(SampleKind kind, size_t components) {
+    switch (kind) {
+        case SampleKind::FLOAT32:
+            return components * sizeof(float);
+        case SampleKind::FLOAT64:
+            return components * sizeof(double);
+        case SampleKind::SCALAR:
+            break;
+    }
+    return 0;
+}
+
+size_t padded(size_t bytes) {
+    return (bytes + 7) & ~size_t(7);
+}
+
+void putBytes(std::vector<char>& out, const void* data, size_t size) {
+    const char* bytes = static_cast<const char*>(data);
+    out.insert(out.end(), bytes, bytes + size);
+}
+
+template<typename T>
+void put(std::vector<char>& out, const T& value) {
+    putBytes(out, &value, sizeof(value));
+}
+
+void putString(std::vector<char>& out, const std::string& s) {
+    put(out, static_cast<uint32_t>(s.size()));
+    putBytes(out, s.data(), s.size());
+}
+
+// Empty on success, the error otherwise
+std::string writeAll(int fd, const char* data, size_t size) {
+    while (size > 0) {
+        ssize_t n = ::write(fd, data, size);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return std::strerror(errno);
+        }
+        data += n;
+        size -= static_cast<size_t>(n);
+    }
+    return {};
+}
+
+// Bounds-checked cursor over one frame
+class FrameCursor {
+public:
+    explicit FrameCursor(const std::vector<char>& frame) : data_(frame.data()), left_(frame.size()) {}
+
+    template<typename T>
+    T get() {
+        T value;
+        getBytes(&value, sizeof(value));
+        return value;
+    }
+
+    void getBytes(void* out, size_t size) {
+        if (size > left_) {
+            throw ReplayException("Corrupt capture: frame shorter than its contents");
+        }
+        std::memcpy(out, data_, size);
+        data_ += size;
+        left_ -= size;
+    }
+
+    std::string rest() { return std::string(data_, left_); }
+
+private:
+    const char* data_;
+    size_t left_;
+};
+
+} // namespace
+
+ReplayWriter::ReplayWriter(const std::string& path, const ReplayHeader& header) : path_(path) {
+    fd_ = ::open(path.c_str(), O_CREAT | O_WRONLY | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd_ < 0) {
+        throw ReplayException("open failed for " + path + ": " + std::strerror(errno));
+    }
+    std::vector<char> out;
+    put(out, FileHeader{REPLAY_MAGIC, REPLAY_VERSION, static_cast<uint32_t>(header.sensors.size()),
+                        static_cast<uint32_t>(header.actuators.size()), 0, header.frequency});
+    putString(out, header.loop);
+    for (const auto& name : header.sensors) {
+        putString(out, name);
+    }
+    for (const auto& name : header.actuators) {
+        putString(out, name);
+    }
+    std::string err = writeAll(fd_, out.data(), out.size());
+    if (!err.empty()) {
+        ::close(fd_);
+        throw ReplayException("writing " + path + " failed: " + err);
+    }
+    pending_.reserve(2 * FLUSH_BYTES);
+    thread_ = std::thread(&ReplayWriter::writerThread, this);
+}
+
+ReplayWriter::~ReplayWriter() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_one();
+    thread_.join();
+    ::close(fd_);
+}
+
+void ReplayWriter::append(uint64_t cycle, TscClock::time_point timestamp, Span<const SensorData> samples,
+                          Span<const VectorSample> vectors, Span<const ActuatorCommand> commands,
+                          bool controlFailed) {
+    static const VectorSample none{};
+    auto vectorOf = [&vectors](size_t i) -> const VectorSample& { return i < vectors.size() ? vectors[i] : none; };
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!error_.empty()) {
+        return;
+    }
+    size_t start = pending_.size();
+    for (const auto& sample : samples) {
+        encodeSignal(sample.id);
+    }
+    for (const auto& cmd : commands) {
+        encodeSignal(cmd.id);
+    }
+
+    size_t size = sizeof(CycleRecord) + commands.size() * sizeof(CommandRecord);
+    for (size_t i = 0; i < samples.size(); ++i) {
+        size += sizeof(SampleRecord) + padded(componentBytes(vectorOf(i).kind, vectorOf(i).components));
+    }
+    put(pending_, FrameHeader{CYCLE_FRAME, static_cast<uint32_t>(size)});
+    put(pending_, CycleRecord{cycle, timestamp.time_since_epoch().count(), static_cast<uint32_t>(samples.size()),
+                              static_cast<uint32_t>(commands.size()), controlFailed ? CONTROL_FAILED : 0u, 0});
+    for (size_t i = 0; i < samples.size(); ++i) {
+        const SensorData& sample = samples[i];
+        const VectorSample& vector = vectorOf(i);
+        put(pending_, SampleRecord{sample.timestamp.time_since_epoch().count(), sample.value, sample.id,
+                                   static_cast<uint8_t>(sample.unit), static_cast<uint8_t>(vector.kind),
+                                   vector.components, 0});
+        size_t bytes = componentBytes(vector.kind, vector.components);
+        putBytes(pending_, &vector.samples, bytes);
+        pending_.resize(pending_.size() + padded(bytes) - bytes, 0);
+    }
+    for (const auto& cmd : commands) {
+        put(pending_, CommandRecord{cmd.value, cmd.id, static_cast<uint32_t>(cmd.unit)});
+    }
+
+    cycles_++;
+    appendedBytes_ += pending_.size() - start;
+    if (pending_.size() >= FLUSH_BYTES) {
+        wake_.notify_one();
+    }
+}
+
+// Called with mutex_ held
+void ReplayWriter::encodeSignal(SignalId id) {
+    if (id == INVALID_SIGNAL || (id < namedSignals_.size() && namedSignals_[id])) {
+        return;
+    }
+    std::string name;
+    try {
+        name = SignalRegistry::instance().name(id);
+    } catch (const std::out_of_range&) {
+        return;     // Replays as INVALID_SIGNAL
+    }
+    if (id >= namedSignals_.size()) {
+        namedSignals_.resize(id + 1, false);
+    }
+    namedSignals_[id] = true;
+    put(pending_, FrameHeader{SIGNAL_FRAME, static_cast<uint32_t>(sizeof(SignalId) + name.size())});
+    put(pending_, id);
+    putBytes(pending_, name.data(), name.size());
+}
+
+void ReplayWriter::flush() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    uint64_t target = appendedBytes_;
+    flushWaiters_++;
+    wake_.notify_one();
+    written_.wait(lock, [&]() { return writtenBytes_ >= target || !error_.empty(); });
+    flushWaiters_--;
+    if (!error_.empty()) {
+        throw ReplayException("writing " + path_ + " failed: " + error_);
+    }
+}
+
+uint64_t ReplayWriter::cycles() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return cycles_;
+}
+
+void ReplayWriter::writerThread() {
+    std::vector<char> writing;
+    writing.reserve(2 * FLUSH_BYTES);
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        wake_.wait_for(lock, FLUSH_INTERVAL, [this]() {
+            return stopping_ || pending_.size() >= FLUSH_BYTES || (flushWaiters_ > 0 && !pending_.empty());
+        });
+        if (pending_.empty()) {
+            if (stopping_) {
+                break;
+            }
+            continue;
+        }
+        writing.swap(pending_);
+        lock.unlock();
+        std::string err = writeAll(fd_, writing.data(), writing.size());
+        size_t written = writing.size();
+        writing.clear();
+        lock.lock();
+        writtenBytes_ += written;
+        if (!err.empty() && error_.empty()) {
+            error_ = err;
+        }
+        written_.notify_all();
+    }
+}
+
+ReplayReader::ReplayReader(const std::string& path) : buffer_(READ_BUFFER_BYTES) {
+    in_.rdbuf()->pubsetbuf(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+    in_.open(path, std::ios::binary);
+    if (!in_) {
+        throw ReplayException("cannot open " + path);
+    }
+    FileHeader header;
+    if (!in_.read(reinterpret_cast<char*>(&header), sizeof(header)) || header.magic != REPLAY_MAGIC) {
+        throw ReplayException(path + " is not a capture");
+    }
+    if (header.version != REPLAY_VERSION) {
+        throw ReplayException(path + ": unsupported capture version " + std::to_string(header.version));
+    }
+
+    auto readString = [&]() {
+        uint32_t size = 0;
+        std::string s;
+        if (in_.read(reinterpret_cast<char*>(&size), sizeof(size)) && size <= MAX_FRAME_BYTES) {
+            s.resize(size);
+            in_.read(&s[0], size);
+        }
+        if (!in_) {
+            throw ReplayException(path + ": capture header is truncated");
+        }
+        return s;
+    };
+    header_.frequency = header.frequency;
+    header_.loop = readString();
+    for (uint32_t i = 0; i < header.sensorCount; ++i) {
+        header_.sensors.push_back(readString());
+    }
+    for (uint32_t i = 0; i < header.actuatorCount; ++i) {
+        header_.actuators.push_back(readString());
+    }
+}
+
+bool ReplayReader::readFrame(uint32_t& type) {
+    FrameHeader frame;
+    in_.read(reinterpret_cast<char*>(&frame), sizeof(frame));
+    if (in_.gcount() == 0) {
+        return false;
+    }
+    if (in_.gcount() != sizeof(frame)) {
+        truncated_ = true;
+        return false;
+    }
+    if (frame.size > MAX_FRAME_BYTES) {
+        throw ReplayException("Corrupt capture: frame of " + std::to_string(frame.size) + " bytes");
+    }
+    frame_.resize(frame.size);
+    in_.read(frame_.data(), frame.size);
+    if (static_cast<uint32_t>(in_.gcount()) != frame.size) {
+        truncated_ = true;
+        return false;
+    }
+    type = frame.type;
+    return true;
+}
+
+bool ReplayReader::next(ReplayCycle& cycle) {
+    auto mapId = [this](SignalId id) { return id < signalMap_.size() ? signalMap_[id] : INVALID_SIGNAL; };
+
+    uint32_t type = 0;
+    while (readFrame(type)) {
+        FrameCursor cursor(frame_);
+        if (type == SIGNAL_FRAME) {
+            auto id = cursor.get<SignalId>();
+            if (id >= signalMap_.size()) {
+                signalMap_.resize(static_cast<size_t>(id) + 1, INVALID_SIGNAL);
+            }
+            signalMap_[id] = SignalRegistry::instance().intern(cursor.rest());
+            continue;
+        }
+        if (type != CYCLE_FRAME) {
+            throw ReplayException("Corrupt capture: unknown frame type " + std::to_string(type));
+        }
+
+        auto record = cursor.get<CycleRecord>();
+        cycle.cycle = record.cycle;
+        cycle.timestamp = TscClock::time_point(TscClock::duration(record.timestampNs));
+        cycle.controlFailed = (record.flags & CONTROL_FAILED) != 0;
+        cycle.samples.resize(record.sampleCount);
+        cycle.vectors.resize(record.sampleCount);
+        for (size_t i = 0; i < cycle.samples.size(); ++i) {
+            auto r = cursor.get<SampleRecord>();
+            SensorData& sample = cycle.samples[i];
+            sample = SensorData();
+            sample.id = mapId(r.id);
+            sample.unit = static_cast<Unit>(r.unit);
+            sample.value = r.value;
+            sample.timestamp = TscClock::time_point(TscClock::duration(r.timestampNs));
+            VectorSample& vector = cycle.vectors[i];
+            vector = VectorSample();
+            vector.id = sample.id;
+            vector.unit = sample.unit;
+            vector.timestamp = sample.timestamp;
+            vector.kind = static_cast<SampleKind>(r.kind);
+            vector.components = r.components;
+            size_t bytes = componentBytes(vector.kind, vector.components);
+            if (bytes > sizeof(vector.samples)) {
+                throw ReplayException("Corrupt capture: sample vector too large");
+            }
+            std::memset(&vector.samples, 0, sizeof(vector.samples));
+            cursor.getBytes(&vector.samples, bytes);
+            char pad[8];
+            cursor.getBytes(pad, padded(bytes) - bytes);
+        }
+        cycle.commands.resize(record.commandCount);
+        for (auto& cmd : cycle.commands) {
+            auto r = cursor.get<CommandRecord>();
+            cmd.id = mapId(r.id);
+            cmd.unit = static_cast<Unit>(r.unit);
+            cmd.value = r.value;
+        }
+        return true;
+    }
+    return false;
+}
+
+void Replayer::attach(ControlSystem& system) {
+    const ReplayHeader& h = header();
+    std::vector<std::shared_ptr<Module>> modules;
+    for (const auto& name : h.sensors) {
+        sensors_.push_back(std::make_shared<ReplaySensor>(name));
+        modules.push_back(sensors_.back());
+    }
+    for (const auto& name : h.actuators) {
+        actuators_.push_back(std::make_shared<CaptureActuator>(name));
+        modules.push_back(actuators_.back());
+    }
+    for (const auto& module : modules) {
+        if (system.getModule<Module>(module->getName())) {
+            throw ControlSystemException("Cannot replay " + h.loop + ": module " + module->getName() +
+                                         " is already loaded");
+        }
+    }
+    ModuleLoadReport report = system.addModules(modules, 1);
+    if (!report.success) {
+        for (const auto& record : report.modules) {
+            if (!record.success) {
+                throw ControlSystemException("Cannot replay " + h.loop + ": " + record.name + ": " + record.error);
+            }
+        }
+    }
+
+    system.createControlLoop(h.loop, h.frequency);
+    for (const auto& name : h.sensors) {
+        system.addSensorToLoop(h.loop, name);
+    }
+    for (const auto& name : h.actuators) {
+        system.addActuatorToLoop(h.loop, name);
+    }
+    system.setLoopClock(h.loop, clock_);
+    system_ = &system;
+}
+
+ReplayResult Replayer::run(uint64_t maxCycles) {
+    if (!system_) {
+        throw std::logic_error("Replayer::run() before attach()");
+    }
+    ReplayResult result;
+    std::vector<uint64_t> counts(actuators_.size());
+    auto wallStart = TscClock::now();
+    TscClock::time_point first{};
+
+    while (result.cycles < maxCycles && reader_.next(cycle_)) {
+        if (cycle_.samples.size() != sensors_.size()) {
+            throw ReplayException("Captured cycle " + std::to_string(cycle_.cycle) + " has " +
+                                  std::to_string(cycle_.samples.size()) + " samples for " +
+                                  std::to_string(sensors_.size()) + " sensors");
+        }
+        for (size_t i = 0; i < sensors_.size(); ++i) {
+            sensors_[i]->stage(cycle_.samples[i], cycle_.vectors[i]);
+        }
+        for (size_t i = 0; i < actuators_.size(); ++i) {
+            counts[i] = actuators_[i]->commandCount();
+        }
+        clock_->set(cycle_.timestamp);
+        system_->stepLoop(header().loop, cycle_.cycle);
+
+        std::string what;
+        if (!compare(cycle_, counts, what)) {
+            if (result.mismatches++ == 0) {
+                result.firstMismatchCycle = cycle_.cycle;
+                result.firstMismatch = what;
+            }
+        }
+        if (result.cycles++ == 0) {
+            first = cycle_.timestamp;
+        }
+        result.capturedTime = cycle_.timestamp - first;
+    }
+    result.truncated = reader_.truncated();
+    result.wallTime = TscClock::now() - wallStart;
+    return result;
+}
+
+bool Replayer::compare(const ReplayCycle& cycle, const std::vector<uint64_t>& countsBefore,
+                       std::string& what) const {
+    for (size_t i = 0; i < actuators_.size(); ++i) {
+        const CaptureActuator& actuator = *actuators_[i];
+        bool commanded = actuator.commandCount() != countsBefore[i];
+        if (cycle.controlFailed || i >= cycle.commands.size()) {
+            if (commanded) {
+                what = actuator.getName() + " was commanded, but the captured cycle produced no command";
+                return false;
+            }
+            continue;
+        }
+        if (!commanded) {
+            what = actuator.getName() + " was not commanded";
+            return false;
+        }
+        const ActuatorCommand& expected = cycle.commands[i];
+        const ActuatorCommand& actual = actuator.lastCommand();
+        if (std::memcmp(&expected.value, &actual.value, sizeof(double)) != 0 || expected.id != actual.id ||
+            expected.unit != actual.unit) {
+            what = actuator.getName() + ": captured " + std::to_string(expected.value) + ", replayed " +
+                   std::to_string(actual.value);
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace dcs
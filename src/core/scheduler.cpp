@@ -0,0 +1,258 @@
+#include <dcs/scheduler.h>
+#include <dcs/utils/realtime.h>
+#include <algorithm>
+#include <cerrno>
+#include <stdexcept>
+#include <time.h>
+
+namespace dcs {
+
+namespace {
+
+constexpr int64_t NS_PER_SEC = 1000000000;
+
+// Upper bound on a single sleep so stop() is honoured even for slow loops
+constexpr int64_t MAX_SLEEP_NS = 100000000;
+
+void sleepUntil(int64_t deadlineNs) {
+    timespec ts;
+    ts.tv_sec = static_cast<time_t>(deadlineNs / NS_PER_SEC);
+    ts.tv_nsec = static_cast<long>(deadlineNs % NS_PER_SEC);
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR) {
+    }
+}
+
+void updateMax(std::atomic<int64_t>& target, int64_t value) {
+    int64_t current = target.load(std::memory_order_relaxed);
+    while (value > current &&
+           !target.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+    }
+}
+
+} // namespace
+
+LoopScheduler::LoopScheduler(const Options& options)
+    : cpus_(options.cpus),
+      prefaultStackBytes_(options.prefaultStackBytes),
+      waitOptions_(options.wait),
+      onSetupWarning_(options.onSetupWarning),
+      workerCount_(options.workerCount ? options.workerCount
+                                       : std::max(1u, std::thread::hardware_concurrency())) {}
+
+LoopScheduler::~LoopScheduler() {
+    stop();
+}
+
+int64_t LoopScheduler::nowNs() {
+    return WaitStrategy::nowNs();   // One time base for releases and the waits onto them
+}
+
+size_t LoopScheduler::addTask(const std::string& name, double frequency, Task task,
+                              const TimingPolicy& policy) {
+    if (running_) {
+        throw std::logic_error("Cannot add task " + name + " while the scheduler is running");
+    }
+    if (frequency <= 0.0) {
+        throw std::invalid_argument("Task " + name + " needs a positive frequency");
+    }
+
+    auto state = std::make_unique<TaskState>();
+    state->name = name;
+    state->frequency = frequency;
+    state->periodNs = static_cast<int64_t>(NS_PER_SEC / frequency);
+    state->task = std::move(task);
+    state->policy = policy;
+    state->waitMode = waitOptions_.mode;
+    state->deadlineNs = policy.deadlineNs > 0 ? policy.deadlineNs : state->periodNs;
+    tasks_.push_back(std::move(state));
+    return tasks_.size() - 1;
+}
+
+void LoopScheduler::setPriority(size_t task, int priority) {
+    if (running_) {
+        throw std::logic_error("Cannot change task priority while the scheduler is running");
+    }
+    tasks_.at(task)->priority = priority;
+}
+
+void LoopScheduler::setWaitMode(size_t task, WaitMode mode) {
+    if (running_) {
+        throw std::logic_error("Cannot change task wait mode while the scheduler is running");
+    }
+    tasks_.at(task)->waitMode = mode;
+}
+
+void LoopScheduler::start() {
+    if (running_.exchange(true)) {
+        return;
+    }
+
+    partition();
+
+    int64_t phase = nowNs();
+    for (auto& task : tasks_) {
+        task->nextReleaseNs = phase;
+    }
+
+    for (size_t i = 0; i < partitions_.size(); ++i) {
+        if (partitions_[i].empty()) {
+            continue;
+        }
+        workers_.emplace_back(&LoopScheduler::runWorker, this, i);
+
+        // Best effort: a forbidden CPU or priority leaves the worker as it was
+        std::vector<int> cpu;
+        if (!cpus_.empty()) {
+            cpu.push_back(cpus_[i % cpus_.size()]);
+        }
+        int priority = 0;
+        for (const TaskState* task : partitions_[i]) {
+            priority = std::max(priority, task->priority);
+        }
+        for (const std::string& error : {setThreadAffinity(workers_.back().native_handle(), cpu),
+                                         setThreadPriority(workers_.back().native_handle(), priority)}) {
+            if (!error.empty() && onSetupWarning_) {
+                onSetupWarning_("Scheduler worker " + std::to_string(i) + ": " + error);
+            }
+        }
+    }
+}
+
+void LoopScheduler::stop() {
+    if (!running_.exchange(false)) {
+        return;
+    }
+    for (auto& worker : workers_) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+    workers_.clear();
+}
+
+LoopTimingStats LoopScheduler::getStats(size_t task) const {
+    const TaskState& state = *tasks_.at(task);
+    LoopTimingStats stats;
+    stats.cycles = state.cycles.load(std::memory_order_relaxed);
+    stats.overruns = state.overruns.load(std::memory_order_relaxed);
+    stats.missedDeadlines = state.missedDeadlines.load(std::memory_order_relaxed);
+    stats.maxResponseNs = state.maxResponseNs.load(std::memory_order_relaxed);
+    stats.rateDivisor = state.rateDivisor.load(std::memory_order_relaxed);
+    stats.lastJitterNs = state.lastJitterNs.load(std::memory_order_relaxed);
+    stats.maxJitterNs = state.maxJitterNs.load(std::memory_order_relaxed);
+    stats.maxExecutionNs = state.maxExecutionNs.load(std::memory_order_relaxed);
+    if (stats.cycles > 0) {
+        stats.avgJitterNs = static_cast<double>(state.totalJitterNs.load(std::memory_order_relaxed)) /
+                            static_cast<double>(stats.cycles);
+    }
+    return stats;
+}
+
+// Rate-monotonic partitioning: assign tasks in decreasing frequency to the
+// least loaded worker, then keep each partition sorted by priority.
+void LoopScheduler::partition() {
+    std::vector<TaskState*> ordered;
+    for (auto& task : tasks_) {
+        ordered.push_back(task.get());
+    }
+    std::stable_sort(ordered.begin(), ordered.end(), [](const TaskState* a, const TaskState* b) {
+        return a->frequency > b->frequency;
+    });
+
+    partitions_.assign(std::min(workerCount_, std::max<size_t>(tasks_.size(), 1)), {});
+    std::vector<double> load(partitions_.size(), 0.0);
+    for (TaskState* task : ordered) {
+        size_t target = std::min_element(load.begin(), load.end()) - load.begin();
+        partitions_[target].push_back(task);
+        load[target] += task->frequency;
+    }
+}
+
+void LoopScheduler::runWorker(size_t worker) {
+    const std::vector<TaskState*>& tasks = partitions_[worker];
+    if (prefaultStackBytes_ > 0) {
+        prefaultStack(prefaultStackBytes_);
+    }
+    // WaitMode values are ordered from least to most eager
+    WaitOptions waitOptions = waitOptions_;
+    waitOptions.mode = WaitMode::SLEEP;
+    for (const TaskState* task : tasks) {
+        waitOptions.mode = std::max(waitOptions.mode, task->waitMode);
+    }
+    WaitStrategy wait(waitOptions);
+
+    while (running_.load(std::memory_order_relaxed)) {
+        int64_t nextRelease = tasks.front()->nextReleaseNs;
+        for (const TaskState* task : tasks) {
+            nextRelease = std::min(nextRelease, task->nextReleaseNs);
+        }
+
+        int64_t now = nowNs();
+        if (nextRelease > now + MAX_SLEEP_NS) {
+            sleepUntil(now + MAX_SLEEP_NS);
+            continue;
+        }
+        if (nextRelease > now) {
+            wait.waitUntil(nextRelease);
+            now = nowNs();
+        }
+
+        // Partitions are sorted by frequency, so due tasks run in RM priority order
+        for (TaskState* task : tasks) {
+            if (task->nextReleaseNs <= now) {
+                runTask(*task, now);
+                now = nowNs();
+            }
+        }
+    }
+}
+
+void LoopScheduler::runTask(TaskState& state, int64_t now) {
+    int64_t release = state.nextReleaseNs;
+    int64_t jitter = now - release;
+
+    state.task();
+
+    int64_t finish = nowNs();
+    state.cycles.fetch_add(1, std::memory_order_relaxed);
+    state.lastJitterNs.store(jitter, std::memory_order_relaxed);
+    state.totalJitterNs.fetch_add(jitter, std::memory_order_relaxed);
+    updateMax(state.maxJitterNs, jitter);
+    updateMax(state.maxExecutionNs, finish - now);
+    updateMax(state.maxResponseNs, finish - release);
+    if (finish - release > state.deadlineNs) {
+        state.missedDeadlines.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    const TimingPolicy& policy = state.policy;
+    uint32_t divisor = state.rateDivisor.load(std::memory_order_relaxed);
+    int64_t period = state.periodNs * divisor;
+    int64_t next = release + period;
+    if (next > finish) {
+        if (policy.overrun == OverrunPolicy::DEGRADE && divisor > 1 &&
+            ++state.onTimeCycles >= policy.recoveryCycles) {
+            state.onTimeCycles = 0;
+            state.rateDivisor.store(divisor / 2, std::memory_order_relaxed);
+        }
+        state.nextReleaseNs = next;
+        return;
+    }
+
+    // Releases in [next, finish] have already passed
+    int64_t missed = (finish - next) / period + 1;
+    int64_t dropped = missed;
+    if (policy.overrun == OverrunPolicy::CATCH_UP) {
+        // Keep the newest maxCatchUp; the worker runs them immediately
+        dropped = std::max<int64_t>(0, missed - static_cast<int64_t>(policy.maxCatchUp));
+    } else if (policy.overrun == OverrunPolicy::DEGRADE) {
+        state.onTimeCycles = 0;
+        if (divisor * 2 <= policy.maxRateDivisor) {
+            state.rateDivisor.store(divisor * 2, std::memory_order_relaxed);
+        }
+    }
+    state.overruns.fetch_add(static_cast<uint64_t>(dropped), std::memory_order_relaxed);
+    // Still on the nominal grid, so the phase survives rate changes
+    state.nextReleaseNs = next + dropped * period;
+}
+
+} // namespace dcs
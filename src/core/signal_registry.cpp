@@ -0,0 +1,54 @@
+#include <dcs/signal_registry.h>
+#include <mutex>
+#include <stdexcept>
+
+namespace dcs {
+
+SignalRegistry& SignalRegistry::instance() {
+    static SignalRegistry registry;
+    return registry;
+}
+
+SignalId SignalRegistry::intern(const std::string& name) {
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        auto it = ids_.find(name);
+        if (it != ids_.end()) {
+            return it->second;
+        }
+    }
+
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    auto it = ids_.find(name);
+    if (it != ids_.end()) {
+        return it->second;
+    }
+    if (names_.size() >= INVALID_SIGNAL) {
+        throw std::length_error("Signal registry exhausted");
+    }
+    auto id = static_cast<SignalId>(names_.size());
+    names_.push_back(name);
+    ids_.emplace(name, id);
+    return id;
+}
+
+SignalId SignalRegistry::find(const std::string& name) const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    auto it = ids_.find(name);
+    return it != ids_.end() ? it->second : INVALID_SIGNAL;
+}
+
+const std::string& SignalRegistry::name(SignalId id) const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    if (id >= names_.size()) {
+        throw std::out_of_range("Unknown signal id " + std::to_string(id));
+    }
+    return names_[id];
+}
+
+size_t SignalRegistry::size() const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return names_.size();
+}
+
+} // namespace dcs
@@ -0,0 +1,265 @@
+#include <dcs/watchdog.h>
+#include <dcs/utils/realtime.h>
+#include <algorithm>
+#include <stdexcept>
+
+namespace dcs {
+
+namespace {
+
+int levelShift(int level) {
+    return level == 0 ? 0 : 8 + 6 * (level - 1);
+}
+
+} // namespace
+
+Watchdog::Watchdog(std::chrono::microseconds tick, size_t capacity)
+    : tick_(tick), capacity_(capacity), beats_(new Beat[capacity]), slots_(SLOT_COUNT, NIL) {
+    if (tick.count() <= 0) {
+        throw std::invalid_argument("Watchdog tick must be positive");
+    }
+    nodes_.reserve(capacity);
+}
+
+Watchdog::~Watchdog() {
+    stop();
+}
+
+WatchId Watchdog::watch(const std::string& name, std::chrono::microseconds timeout, ExpiryCallback onExpiry) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    uint32_t id;
+    if (!freeList_.empty()) {
+        id = freeList_.back();
+        freeList_.pop_back();
+    } else if (nodes_.size() < capacity_) {
+        id = static_cast<uint32_t>(nodes_.size());
+        nodes_.emplace_back();
+    } else {
+        throw std::length_error("Watchdog full, cannot watch " + name);
+    }
+
+    Node& node = nodes_[id];
+    node.name = name;
+    node.onExpiry = std::move(onExpiry);
+    node.timeout = toTicks(timeout);
+    node.active = true;
+    node.expired = false;
+    uint64_t current = now();
+    beats_[id].lastTick.store(current, std::memory_order_relaxed);
+    if (node.timeout) {
+        schedule(id, current + node.timeout);
+    }
+    active_++;
+    return id;
+}
+
+void Watchdog::unwatch(WatchId id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    checkId(id);
+    unlink(id);
+    Node& node = nodes_[id];
+    node.active = false;
+    node.name.clear();
+    node.onExpiry = nullptr;
+    beats_[id].generation.fetch_add(1, std::memory_order_relaxed);
+    freeList_.push_back(id);
+    active_--;
+}
+
+void Watchdog::setTimeout(WatchId id, std::chrono::microseconds timeout) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    checkId(id);
+    Node& node = nodes_[id];
+    node.timeout = toTicks(timeout);
+    node.expired = false;
+    unlink(id);
+    if (node.timeout) {
+        uint64_t last = beats_[id].lastTick.load(std::memory_order_relaxed);
+        schedule(id, std::max(last + node.timeout, now() + 1));
+    }
+}
+
+Heartbeat Watchdog::heartbeat(WatchId id) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (id >= nodes_.size() || !nodes_[id].active) {
+        return Heartbeat{};
+    }
+    Beat& beat = beats_[id];
+    return Heartbeat(&now_, &beat.lastTick, &beat.generation,
+                     beat.generation.load(std::memory_order_relaxed));
+}
+
+bool Watchdog::isExpired(WatchId id) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    checkId(id);
+    return nodes_[id].expired;
+}
+
+size_t Watchdog::watchCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return active_;
+}
+
+std::string Watchdog::start() {
+    if (running_.exchange(true)) {
+        return {};
+    }
+    thread_ = std::thread(&Watchdog::run, this);
+    return setThreadAffinity(thread_.native_handle(), cpus_);
+}
+
+std::string Watchdog::setCpus(const std::vector<int>& cpus) {
+    cpus_ = cpus;
+    return thread_.joinable() ? setThreadAffinity(thread_.native_handle(), cpus_) : std::string();
+}
+
+void Watchdog::stop() {
+    running_ = false;
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+void Watchdog::run() {
+    auto next = std::chrono::steady_clock::now() + tick_;
+    while (running_) {
+        std::this_thread::sleep_until(next);
+        // After oversleeping, catch up so the tick count keeps tracking real time
+        auto current = std::chrono::steady_clock::now();
+        while (next <= current && running_) {
+            advance();
+            next += tick_;
+        }
+    }
+}
+
+void Watchdog::advance() {
+    struct Expiry {
+        ExpiryCallback callback;
+        WatchId id;
+        std::string name;
+        uint64_t missed;
+    };
+    std::vector<Expiry> expired;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        uint64_t current = now_.load(std::memory_order_relaxed) + 1;
+        now_.store(current, std::memory_order_relaxed);
+
+        // Pull coarser slots down when the finer level wraps, highest first
+        int top = 0;
+        for (int level = 1; level < LEVELS; ++level) {
+            if ((current & ((uint64_t{1} << levelShift(level)) - 1)) != 0) {
+                break;
+            }
+            top = level;
+        }
+        for (int level = top; level >= 1; --level) {
+            cascade(level);
+        }
+
+        uint32_t slot = static_cast<uint32_t>(current & ((1u << LEVEL0_BITS) - 1));
+        uint32_t id = slots_[slot];
+        slots_[slot] = NIL;
+        while (id != NIL) {
+            Node& node = nodes_[id];
+            uint32_t next = node.next;
+            node.slot = node.next = node.prev = NIL;
+
+            uint64_t last = beats_[id].lastTick.load(std::memory_order_relaxed);
+            uint64_t deadline = last + node.timeout;
+            if (deadline > current) {
+                node.expired = false;
+                schedule(id, deadline);
+            } else {
+                // Report once per outage, then keep checking for recovery
+                if (!node.expired && node.onExpiry) {
+                    expired.push_back({node.onExpiry, id, node.name, current - last});
+                }
+                node.expired = true;
+                schedule(id, current + node.timeout);
+            }
+            id = next;
+        }
+    }
+    for (auto& e : expired) {
+        e.callback(e.id, e.name, e.missed);
+    }
+}
+
+uint64_t Watchdog::toTicks(std::chrono::microseconds timeout) const {
+    if (timeout.count() < 0) {
+        throw std::invalid_argument("Watchdog timeout must not be negative");
+    }
+    if (timeout.count() == 0) {
+        return 0;
+    }
+    uint64_t ticks = static_cast<uint64_t>((timeout.count() + tick_.count() - 1) / tick_.count());
+    return std::min(std::max<uint64_t>(ticks, 1), MAX_TICKS);
+}
+
+// File `id` in the slot of the finest level whose range covers `due`
+void Watchdog::schedule(uint32_t id, uint64_t due) {
+    uint64_t current = now();
+    due = std::min(std::max(due, current), current + MAX_TICKS);
+    uint64_t delta = due - current;
+
+    int level = 0;
+    while (level < LEVELS - 1 && delta >= (uint64_t{1} << levelShift(level + 1))) {
+        level++;
+    }
+    uint32_t slot;
+    if (level == 0) {
+        slot = static_cast<uint32_t>(due & ((1u << LEVEL0_BITS) - 1));
+    } else {
+        slot = (1u << LEVEL0_BITS) + (level - 1) * (1u << LEVELN_BITS) +
+               static_cast<uint32_t>((due >> levelShift(level)) & ((1u << LEVELN_BITS) - 1));
+    }
+
+    Node& node = nodes_[id];
+    node.due = due;
+    node.slot = slot;
+    node.prev = NIL;
+    node.next = slots_[slot];
+    if (node.next != NIL) {
+        nodes_[node.next].prev = id;
+    }
+    slots_[slot] = id;
+}
+
+void Watchdog::unlink(uint32_t id) {
+    Node& node = nodes_[id];
+    if (node.slot == NIL) {
+        return;
+    }
+    if (node.prev != NIL) {
+        nodes_[node.prev].next = node.next;
+    } else {
+        slots_[node.slot] = node.next;
+    }
+    if (node.next != NIL) {
+        nodes_[node.next].prev = node.prev;
+    }
+    node.slot = node.next = node.prev = NIL;
+}
+
+void Watchdog::cascade(int level) {
+    uint32_t slot = (1u << LEVEL0_BITS) + (level - 1) * (1u << LEVELN_BITS) +
+                    static_cast<uint32_t>((now() >> levelShift(level)) & ((1u << LEVELN_BITS) - 1));
+    uint32_t id = slots_[slot];
+    slots_[slot] = NIL;
+    while (id != NIL) {
+        uint32_t next = nodes_[id].next;
+        nodes_[id].slot = NIL;
+        schedule(id, nodes_[id].due);
+        id = next;
+    }
+}
+
+void Watchdog::checkId(WatchId id) const {
+    if (id >= nodes_.size() || !nodes_[id].active) {
+        throw std::invalid_argument("Unknown watch " + std::to_string(id));
+    }
+}
+
+} // namespace dcs
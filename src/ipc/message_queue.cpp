@@ -0,0 +1,45 @@
+#include <dcs/message_queue.h>
+#include <cstdlib>
+
+namespace dcs {
+
+MessageQueue::MessageQueue(size_t capacity, QueueMode mode) : mode_(mode) {
+    if (capacity == 0) {
+        throw SharedMemoryException("Message queue capacity must be non-zero");
+    }
+    size_t bytes = bytesFor(capacity, mode);
+    bytes = (bytes + CACHE_LINE_SIZE - 1) & ~(CACHE_LINE_SIZE - 1);
+    localMemory_ = std::aligned_alloc(CACHE_LINE_SIZE, bytes);
+    if (!localMemory_) {
+        throw std::bad_alloc();
+    }
+    attach(localMemory_, capacity, true);
+}
+
+MessageQueue::MessageQueue(SharedMemory& shm, const std::string& name, size_t capacity,
+                           QueueMode mode)
+    : mode_(mode) {
+    if (capacity == 0) {
+        throw SharedMemoryException("Message queue capacity must be non-zero");
+    }
+    bool created = false;
+    void* memory = shm.reserve("mq:" + name, bytesFor(capacity, mode), CACHE_LINE_SIZE,
+                               [&](void* region) { attach(region, capacity, true); }, &created);
+    if (!created) {
+        attach(memory, capacity, false);
+    }
+}
+
+MessageQueue::~MessageQueue() {
+    std::free(localMemory_);
+}
+
+void MessageQueue::attach(void* memory, size_t capacity, bool initialize) {
+    if (mode_ == QueueMode::SPSC) {
+        spsc_.attach(memory, capacity, initialize);
+    } else {
+        mpmc_.attach(memory, capacity, initialize);
+    }
+}
+
+} // namespace dcs
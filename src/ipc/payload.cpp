@@ -0,0 +1,110 @@
+#include <dcs/payload.h>
+#include <new>
+#include <stdexcept>
+
+namespace dcs {
+
+SharedPayload::SharedPayload(const SharedPayload& other) : pool_(other.pool_), header_(other.header_) {
+    if (header_) {
+        header_->refs.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+SharedPayload& SharedPayload::operator=(const SharedPayload& other) {
+    if (this != &other) {
+        SharedPayload copy(other);
+        *this = std::move(copy);
+    }
+    return *this;
+}
+
+SharedPayload::SharedPayload(SharedPayload&& other) noexcept : pool_(other.pool_), header_(other.header_) {
+    other.pool_ = nullptr;
+    other.header_ = nullptr;
+}
+
+SharedPayload& SharedPayload::operator=(SharedPayload&& other) noexcept {
+    if (this != &other) {
+        reset();
+        pool_ = other.pool_;
+        header_ = other.header_;
+        other.pool_ = nullptr;
+        other.header_ = nullptr;
+    }
+    return *this;
+}
+
+SharedPayload SharedPayload::create(SharedMemoryPool& pool, size_t size, uint32_t owner) {
+    void* memory = pool.allocate(sizeof(Header) + size, owner);
+    if (!memory) {
+        throw SharedMemoryException("Shared memory pool exhausted allocating a " +
+                                    std::to_string(size) + " byte payload");
+    }
+    auto header = new (memory) Header;
+    header->refs.store(1, std::memory_order_relaxed);
+    header->size = size;
+    return SharedPayload(&pool, header);
+}
+
+SharedPayload SharedPayload::adopt(SharedMemoryPool& pool, PayloadRef ref) {
+    return ref ? SharedPayload(&pool, headerAt(pool, ref)) : SharedPayload();
+}
+
+SharedPayload SharedPayload::retain(SharedMemoryPool& pool, PayloadRef ref) {
+    if (!ref) {
+        return SharedPayload();
+    }
+    Header* header = headerAt(pool, ref);
+    header->refs.fetch_add(1, std::memory_order_relaxed);
+    return SharedPayload(&pool, header);
+}
+
+Span<const uint8_t> SharedPayload::view(const SharedMemoryPool& pool, PayloadRef ref) {
+    if (!ref) {
+        return {};
+    }
+    return Span<const uint8_t>(reinterpret_cast<const uint8_t*>(headerAt(pool, ref) + 1), ref.size);
+}
+
+PayloadRef SharedPayload::share() const {
+    if (!header_) {
+        return {};
+    }
+    header_->refs.fetch_add(1, std::memory_order_relaxed);
+    return ref();
+}
+
+PayloadRef SharedPayload::ref() const {
+    if (!header_) {
+        return {};
+    }
+    return {pool_->toOffset(header_).offset, header_->size};
+}
+
+Span<const uint8_t> SharedPayload::view() const {
+    return header_ ? Span<const uint8_t>(bytes(), header_->size) : Span<const uint8_t>();
+}
+
+Span<uint8_t> SharedPayload::writable() {
+    if (!header_) {
+        return {};
+    }
+    if (header_->refs.load(std::memory_order_acquire) != 1) {
+        throw std::logic_error("Payload is shared and read-only");
+    }
+    return Span<uint8_t>(bytes(), header_->size);
+}
+
+void SharedPayload::reset() {
+    if (!header_) {
+        return;
+    }
+    // Release publishes our reads/writes before the block can be reused
+    if (header_->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        pool_->deallocate(header_);
+    }
+    pool_ = nullptr;
+    header_ = nullptr;
+}
+
+} // namespace dcs
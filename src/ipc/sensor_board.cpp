@@ -0,0 +1,191 @@
+#include <dcs/sensor_board.h>
+#include <algorithm>
+#include <cstdlib>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <new>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+namespace dcs {
+
+SensorBoard::SensorBoard(size_t capacity) : capacity_(capacity) {
+    if (capacity_ == 0) {
+        throw SharedMemoryException("Sensor board capacity must be non-zero");
+    }
+    localMemory_ = std::aligned_alloc(CACHE_LINE_SIZE, bytesFor(capacity_));
+    if (!localMemory_) {
+        throw std::bad_alloc();
+    }
+    initialize(localMemory_, true);
+}
+
+SensorBoard::SensorBoard(SharedMemory& shm, size_t capacity) : capacity_(capacity) {
+    if (capacity_ == 0) {
+        throw SharedMemoryException("Sensor board capacity must be non-zero");
+    }
+    bool created = false;
+    void* memory = shm.reserve(REGION_NAME, bytesFor(capacity_), CACHE_LINE_SIZE,
+                               [&](void* region) { initialize(region, true); }, &created);
+    if (!created) {
+        initialize(memory, false);
+    }
+}
+
+SensorBoard::~SensorBoard() {
+    std::free(localMemory_);
+}
+
+namespace {
+
+enum : uint32_t { EMPTY = 0, CLAIMING = 1, NAMED = 2 };
+
+uint64_t hashName(const std::string& name) {
+    uint64_t hash = 0xcbf29ce484222325ULL;    // FNV-1a
+    for (unsigned char c : name) {
+        hash = (hash ^ c) * 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+} // namespace
+
+void SensorBoard::initialize(void* memory, bool create) {
+    header_ = static_cast<Header*>(memory);
+
+    if (create) {
+        header_->capacity = capacity_;
+        new (&header_->updates) std::atomic<uint32_t>(0);
+    } else {
+        // The layout, and the directory hash, follow whoever created the board
+        capacity_ = header_->capacity;
+    }
+    slots_ = reinterpret_cast<Slot*>(header_ + 1);
+    directory_ = reinterpret_cast<DirectoryEntry*>(slots_ + capacity_);
+    if (create) {
+        for (size_t i = 0; i < capacity_; ++i) {
+            new (&slots_[i].sequence) std::atomic<uint64_t>(0);
+            for (auto& word : slots_[i].words) {
+                new (&word) std::atomic<uint64_t>(0);
+            }
+            new (&slots_[i].waiters) std::atomic<uint32_t>(0);
+            new (&directory_[i].state) std::atomic<uint32_t>(EMPTY);
+        }
+    }
+
+    slotCache_.reset(new std::atomic<uint32_t>[capacity_]);
+    for (size_t i = 0; i < capacity_; ++i) {
+        slotCache_[i].store(UNRESOLVED, std::memory_order_relaxed);
+    }
+}
+
+// Slow path: find (or, to publish, claim) the directory entry for the id's
+// name. Entries only ever go EMPTY -> CLAIMING -> NAMED, and CLAIMING lasts
+// one short copy, so a probe that meets one waits it out.
+uint32_t SensorBoard::resolveSlot(SignalId id, bool claim) const {
+    auto& registry = SignalRegistry::instance();
+    if (id >= registry.size()) {
+        return NO_SLOT;
+    }
+    const std::string& name = registry.name(id);
+    if (name.size() > MAX_SIGNAL_NAME) {
+        return NO_SLOT;
+    }
+
+    size_t start = static_cast<size_t>(hashName(name) % capacity_);
+    for (size_t probe = 0; probe < capacity_; ++probe) {
+        size_t index = (start + probe) % capacity_;
+        DirectoryEntry& entry = directory_[index];
+        uint32_t state = entry.state.load(std::memory_order_acquire);
+        if (state == EMPTY) {
+            if (!claim) {
+                return NO_SLOT;     // Never published; nothing to cache yet
+            }
+            if (entry.state.compare_exchange_strong(state, CLAIMING, std::memory_order_acquire)) {
+                std::memset(entry.name, 0, sizeof(entry.name));
+                std::memcpy(entry.name, name.data(), name.size());
+                entry.state.store(NAMED, std::memory_order_release);
+                state = NAMED;
+            }
+        }
+        while (state == CLAIMING) {
+            cpuRelax();
+            state = entry.state.load(std::memory_order_acquire);
+        }
+        if (std::strncmp(entry.name, name.c_str(), sizeof(entry.name)) == 0) {
+            if (id < capacity_) {
+                slotCache_[id].store(static_cast<uint32_t>(index), std::memory_order_relaxed);
+            }
+            return static_cast<uint32_t>(index);
+        }
+    }
+    return NO_SLOT;     // Full
+}
+
+// FUTEX_WAIT_BITSET takes an absolute CLOCK_MONOTONIC deadline, so a waiter
+// re-sleeping after an unrelated wake-up does not stretch its timeout
+bool SensorBoard::waitForUpdate(const std::vector<SignalId>& ids, uint32_t seen, int64_t deadlineNs) const {
+    timespec ts;
+    ts.tv_sec = static_cast<time_t>(deadlineNs / 1000000000);
+    ts.tv_nsec = static_cast<long>(deadlineNs % 1000000000);
+
+    // Claiming the slots of signals not yet published lets their first publish
+    // wake us; once claimed, a slot index is cached and stable
+    uint32_t mask = 0;
+    for (SignalId id : ids) {
+        uint32_t index = slotFor(id, true);
+        if (index != NO_SLOT) {
+            slots_[index].waiters.fetch_add(1, std::memory_order_seq_cst);
+            mask |= futexBit(index);
+        }
+    }
+    if (mask == 0) {
+        // Nothing we watch can ever be published
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR) {
+        }
+        return false;
+    }
+
+    // Not FUTEX_PRIVATE: waiters and publishers may be in different processes.
+    // The kernel re-checks the word, so a publish since `seen` returns at once.
+    if (header_->updates.load(std::memory_order_seq_cst) == seen) {
+        syscall(SYS_futex, reinterpret_cast<uint32_t*>(&header_->updates), FUTEX_WAIT_BITSET, seen, &ts,
+                nullptr, mask);
+    }
+    for (SignalId id : ids) {
+        uint32_t index = slotFor(id, false);
+        if (index != NO_SLOT) {
+            slots_[index].waiters.fetch_sub(1, std::memory_order_relaxed);
+        }
+    }
+    return updateCount() != seen;
+}
+
+void SensorBoard::wakeWaiters(uint32_t index) const {
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&header_->updates), FUTEX_WAKE_BITSET, INT_MAX, nullptr,
+            nullptr, futexBit(index));
+}
+
+SensorData SensorModule::poll() {
+    return publish(read());
+}
+
+SensorData SensorModule::poll(VectorSample& vector) {
+    return publish(readSample(vector));
+}
+
+SensorData SensorModule::publish(const SensorData& data) {
+    publishedSignal_.store(data.id, std::memory_order_relaxed);
+    if (sensorBoard_) {
+        // The board keeps no references, so it never carries payloads
+        SensorData latest = data;
+        latest.payload = PayloadRef{};
+        sensorBoard_->publish(latest);
+    }
+    return data;
+}
+
+} // namespace dcs
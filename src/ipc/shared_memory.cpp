@@ -0,0 +1,179 @@
+#include <dcs/shared_memory.h>
+#include <cerrno>
+#include <cstring>
+#include <new>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace dcs {
+
+namespace {
+
+constexpr uint64_t SEGMENT_MAGIC = 0x4443534D454D3031ULL; // "DCSMEM01"
+
+uint64_t alignUp(uint64_t value, uint64_t alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+std::string segmentPath(const std::string& name) {
+    return name.empty() || name[0] != '/' ? "/" + name : name;
+}
+
+} // namespace
+
+SharedMemory::SharedMemory(const std::string& name, size_t size, bool create)
+    : name_(segmentPath(name)), size_(size), owner_(create) {
+    static_assert(std::atomic<uint32_t>::is_always_lock_free,
+                  "shared memory requires lock-free atomics");
+
+    if (size_ < sizeof(Header)) {
+        throw SharedMemoryException("Shared memory segment too small: " + name_);
+    }
+
+    int flags = create ? (O_CREAT | O_RDWR) : O_RDWR;
+    fd_ = shm_open(name_.c_str(), flags, 0660);
+    if (fd_ < 0) {
+        throw SharedMemoryException("shm_open failed for " + name_ + ": " + std::strerror(errno));
+    }
+
+    if (create && ftruncate(fd_, static_cast<off_t>(size_)) != 0) {
+        int err = errno;
+        close(fd_);
+        shm_unlink(name_.c_str());
+        throw SharedMemoryException("ftruncate failed for " + name_ + ": " + std::strerror(err));
+    }
+
+    base_ = mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if (base_ == MAP_FAILED) {
+        int err = errno;
+        close(fd_);
+        if (create) {
+            shm_unlink(name_.c_str());
+        }
+        throw SharedMemoryException("mmap failed for " + name_ + ": " + std::strerror(err));
+    }
+
+    Header* hdr = header();
+    if (create) {
+        hdr->size = size_;
+        new (&hdr->lock) std::atomic<uint32_t>(0);
+        hdr->regionCount = 0;
+        hdr->nextOffset = alignUp(sizeof(Header), CACHE_LINE_SIZE);
+        std::atomic_thread_fence(std::memory_order_release);
+        hdr->magic = SEGMENT_MAGIC;
+    } else if (hdr->magic != SEGMENT_MAGIC || hdr->size != size_) {
+        munmap(base_, size_);
+        close(fd_);
+        throw SharedMemoryException("Incompatible shared memory segment: " + name_);
+    }
+}
+
+SharedMemory::~SharedMemory() {
+    if (base_ && base_ != MAP_FAILED) {
+        munmap(base_, size_);
+    }
+    if (fd_ >= 0) {
+        close(fd_);
+    }
+    if (owner_) {
+        shm_unlink(name_.c_str());
+    }
+}
+
+size_t SharedMemory::available() const {
+    lockDirectory();
+    size_t remaining = size_ - header()->nextOffset;
+    unlockDirectory();
+    return remaining;
+}
+
+void* SharedMemory::reserve(const std::string& regionName, size_t bytes,
+                            size_t alignment, const RegionInit& init, bool* created) {
+    if (regionName.empty() || regionName.size() > MAX_REGION_NAME) {
+        throw SharedMemoryException("Invalid shared memory region name: " + regionName);
+    }
+    if (alignment == 0 || (alignment & (alignment - 1)) != 0) {
+        throw SharedMemoryException("Region alignment must be a power of two");
+    }
+
+    lockDirectory();
+    if (const Region* existing = findRegion(regionName)) {
+        uint64_t offset = existing->offset;
+        bool fits = existing->size >= bytes;
+        unlockDirectory();
+        if (!fits) {
+            throw SharedMemoryException("Region " + regionName + " exists with a smaller size");
+        }
+        if (created) {
+            *created = false;
+        }
+        return at<void>(offset);
+    }
+
+    Header* hdr = header();
+    uint64_t offset = alignUp(hdr->nextOffset, alignment);
+    if (hdr->regionCount == MAX_REGIONS || offset + bytes > size_) {
+        unlockDirectory();
+        throw SharedMemoryException("Shared memory exhausted reserving " + regionName);
+    }
+
+    if (init) {
+        try {
+            init(at<void>(offset));
+        } catch (...) {
+            unlockDirectory();
+            throw;
+        }
+    }
+
+    Region& region = hdr->regions[hdr->regionCount];
+    std::memset(region.name, 0, sizeof(region.name));
+    std::memcpy(region.name, regionName.data(), regionName.size());
+    region.offset = offset;
+    region.size = bytes;
+    hdr->nextOffset = offset + bytes;
+    hdr->regionCount++;
+    unlockDirectory();
+
+    if (created) {
+        *created = true;
+    }
+    return at<void>(offset);
+}
+
+void* SharedMemory::find(const std::string& regionName) const {
+    lockDirectory();
+    const Region* region = findRegion(regionName);
+    void* ptr = region ? at<void>(region->offset) : nullptr;
+    unlockDirectory();
+    return ptr;
+}
+
+const SharedMemory::Region* SharedMemory::findRegion(const std::string& regionName) const {
+    const Header* hdr = header();
+    for (uint32_t i = 0; i < hdr->regionCount; ++i) {
+        if (regionName == hdr->regions[i].name) {
+            return &hdr->regions[i];
+        }
+    }
+    return nullptr;
+}
+
+// The directory is only touched at setup time, so a spinlock in the segment
+// itself is enough and works across processes.
+void SharedMemory::lockDirectory() const {
+    auto& lock = header()->lock;
+    while (lock.exchange(1, std::memory_order_acquire) != 0) {
+        while (lock.load(std::memory_order_relaxed) != 0) {
+            cpuRelax();
+        }
+    }
+}
+
+void SharedMemory::unlockDirectory() const {
+    header()->lock.store(0, std::memory_order_release);
+}
+
+} // namespace dcs
@@ -0,0 +1,207 @@
+#include <dcs/shared_memory_pool.h>
+#include <chrono>
+#include <new>
+#include <stdexcept>
+#include <thread>
+
+namespace dcs {
+
+namespace {
+
+constexpr uint64_t POOL_MAGIC = 0x4443535F504F4F4CULL;   // "DCS_POOL"
+constexpr uint64_t INDEX_MASK = 0xFFFFFFFFull;
+// How long releaseOwner() waits for a carver to publish a block header. A
+// live carver takes nanoseconds unless preempted; one that died never does.
+constexpr auto PUBLISH_WAIT = std::chrono::milliseconds(10);
+constexpr int PUBLISH_SPINS = 64;
+
+} // namespace
+
+SharedMemoryPool::SharedMemoryPool(SharedMemory& shm, size_t bytes, const std::string& name) : shm_(shm) {
+    if (bytes < sizeof(PoolHeader) + blockSize(0)) {
+        throw SharedMemoryException("Shared memory pool too small: " + name);
+    }
+    // Block indices are 32-bit in units of a cache line
+    if (bytes - sizeof(PoolHeader) > INDEX_MASK * CACHE_LINE_SIZE) {
+        throw SharedMemoryException("Shared memory pool too large: " + name);
+    }
+
+    auto init = [bytes](void* region) {
+        auto header = static_cast<PoolHeader*>(region);
+        header->capacity = bytes - sizeof(PoolHeader);
+        // Unique per pool so block headers left in a reused segment by an
+        // earlier run never look published
+        auto stamp = static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+        header->blockMagic = static_cast<uint32_t>(stamp ^ (stamp >> 32)) | 1u;
+        new (&header->cursor) std::atomic<uint64_t>(0);
+        for (auto& list : header->freeLists) {
+            new (&list.head) std::atomic<uint64_t>(0);
+        }
+        header->magic = POOL_MAGIC;
+    };
+    void* memory = shm.reserve("pool:" + name, bytes, CACHE_LINE_SIZE, init);
+    header_ = static_cast<PoolHeader*>(memory);
+    blocks_ = static_cast<char*>(memory) + sizeof(PoolHeader);
+    if (header_->magic != POOL_MAGIC) {
+        throw SharedMemoryException("Incompatible shared memory pool: " + name);
+    }
+    capacity_ = header_->capacity;
+    blockMagic_ = header_->blockMagic;
+}
+
+size_t SharedMemoryPool::sizeClassFor(size_t bytes) {
+    if (bytes > blockSize(CLASS_COUNT - 1) - HEADER_SIZE) {
+        return CLASS_COUNT;
+    }
+    size_t total = bytes + HEADER_SIZE;
+    if (total <= blockSize(0)) {
+        return 0;
+    }
+    // Smallest power of two >= total is 2^bits; take 1.5 * 2^(bits-1) if it fits
+    size_t bits = 64 - static_cast<size_t>(__builtin_clzll(total - 1));
+    size_t powerClass = 2 * (bits - MIN_BLOCK_BITS);
+    return blockSize(powerClass - 1) >= total ? powerClass - 1 : powerClass;
+}
+
+void* SharedMemoryPool::allocate(size_t bytes, uint32_t owner) {
+    if (owner == FREE_OWNER) {
+        throw std::invalid_argument("Shared memory pool owner must be non-zero");
+    }
+    size_t sizeClass = sizeClassFor(bytes);
+    if (sizeClass >= CLASS_COUNT) {
+        return nullptr;
+    }
+    BlockHeader* block = pop(sizeClass);
+    if (block) {
+        block->owner.store(owner, std::memory_order_relaxed);
+    } else {
+        block = carve(sizeClass, owner);
+        if (!block) {
+            return nullptr;
+        }
+    }
+    return reinterpret_cast<char*>(block) + HEADER_SIZE;
+}
+
+void SharedMemoryPool::deallocate(void* ptr) {
+    if (!ptr) {
+        return;
+    }
+    BlockHeader* block = headerOf(ptr);
+    if (static_cast<char*>(ptr) <= blocks_ || static_cast<char*>(ptr) >= blocks_ + capacity_ ||
+        block->magic.load(std::memory_order_relaxed) != blockMagic_) {
+        throw SharedMemoryException("Pointer was not allocated from this pool");
+    }
+    uint32_t owner = block->owner.load(std::memory_order_relaxed);
+    // Losing the race means releaseOwner() already took it back
+    if (owner != FREE_OWNER &&
+        block->owner.compare_exchange_strong(owner, FREE_OWNER, std::memory_order_acq_rel)) {
+        push(block);
+    }
+}
+
+size_t SharedMemoryPool::releaseOwner(uint32_t owner) {
+    if (owner == FREE_OWNER) {
+        return 0;
+    }
+    // Blocks tile [0, cursor) back to back, so their headers can be walked
+    // without any side table. Blocks carved after the cursor load are skipped.
+    size_t freed = 0;
+    uint64_t end = header_->cursor.load(std::memory_order_acquire);
+    uint64_t offset = 0;
+    while (offset < end) {
+        auto block = reinterpret_cast<BlockHeader*>(blocks_ + offset);
+        // A carver may have claimed the space but not yet published the
+        // header. Without the header the walk cannot step past the block, so
+        // one that stays unpublished ends it.
+        if (!awaitPublished(block)) {
+            break;
+        }
+        uint32_t expected = owner;
+        if (block->owner.load(std::memory_order_relaxed) == owner &&
+            block->owner.compare_exchange_strong(expected, FREE_OWNER, std::memory_order_acq_rel)) {
+            push(block);
+            freed++;
+        }
+        offset += blockSize(block->sizeClass);
+    }
+    return freed;
+}
+
+bool SharedMemoryPool::awaitPublished(const BlockHeader* block) const {
+    for (int spin = 0; spin < PUBLISH_SPINS; ++spin) {
+        if (block->magic.load(std::memory_order_acquire) == blockMagic_) {
+            return true;
+        }
+        cpuRelax();
+    }
+    auto deadline = std::chrono::steady_clock::now() + PUBLISH_WAIT;
+    while (block->magic.load(std::memory_order_acquire) != blockMagic_) {
+        if (std::chrono::steady_clock::now() >= deadline) {
+            return false;
+        }
+        std::this_thread::yield();
+    }
+    return true;
+}
+
+uint64_t SharedMemoryPool::carvedBytes() const {
+    return header_->cursor.load(std::memory_order_relaxed);
+}
+
+size_t SharedMemoryPool::usableSize(const void* ptr) {
+    return blockSize(headerOf(ptr)->sizeClass) - HEADER_SIZE;
+}
+
+uint32_t SharedMemoryPool::ownerOf(const void* ptr) {
+    return headerOf(ptr)->owner.load(std::memory_order_relaxed);
+}
+
+SharedMemoryPool::BlockHeader* SharedMemoryPool::pop(size_t sizeClass) {
+    auto& head = header_->freeLists[sizeClass].head;
+    uint64_t current = head.load(std::memory_order_acquire);
+    while (current & INDEX_MASK) {
+        BlockHeader* block = blockAt((current & INDEX_MASK) - 1);
+        // May read a link a concurrent pop already changed; the tag then fails the CAS
+        uint64_t next = block->next.load(std::memory_order_relaxed);
+        uint64_t replacement = (((current >> 32) + 1) << 32) | next;
+        if (head.compare_exchange_weak(current, replacement, std::memory_order_acq_rel,
+                                       std::memory_order_acquire)) {
+            return block;
+        }
+    }
+    return nullptr;
+}
+
+void SharedMemoryPool::push(BlockHeader* block) {
+    auto& head = header_->freeLists[block->sizeClass].head;
+    uint64_t index = indexOf(block) + 1;
+    uint64_t current = head.load(std::memory_order_relaxed);
+    uint64_t replacement;
+    do {
+        block->next.store(current & INDEX_MASK, std::memory_order_relaxed);
+        replacement = (((current >> 32) + 1) << 32) | index;
+    } while (!head.compare_exchange_weak(current, replacement, std::memory_order_release,
+                                         std::memory_order_relaxed));
+}
+
+SharedMemoryPool::BlockHeader* SharedMemoryPool::carve(size_t sizeClass, uint32_t owner) {
+    uint64_t size = blockSize(sizeClass);
+    uint64_t offset = header_->cursor.load(std::memory_order_relaxed);
+    do {
+        if (offset + size > capacity_) {
+            return nullptr;
+        }
+    } while (!header_->cursor.compare_exchange_weak(offset, offset + size, std::memory_order_acq_rel,
+                                                    std::memory_order_relaxed));
+
+    // Leaves magic untouched until the rest of the header is written
+    auto block = new (blocks_ + offset) BlockHeader;
+    block->next.store(0, std::memory_order_relaxed);
+    block->owner.store(owner, std::memory_order_relaxed);
+    block->sizeClass = static_cast<uint32_t>(sizeClass);
+    block->magic.store(blockMagic_, std::memory_order_release);
+    return block;
+}
+
+} // namespace dcs
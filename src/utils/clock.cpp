@@ -0,0 +1,147 @@
+#include <dcs/utils/clock.h>
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <string>
+#include <thread>
+
+#if defined(__x86_64__)
+#include <cpuid.h>
+#endif
+
+namespace dcs {
+
+namespace {
+
+#if defined(__x86_64__)
+constexpr auto CALIBRATION_PERIOD = std::chrono::milliseconds(20);
+constexpr auto RECALIBRATION_PERIOD = std::chrono::seconds(1);
+// Largest rate correction while slewing, so time never steps or runs backwards
+constexpr double MAX_SLEW = 500e-6;
+constexpr double MIN_TSC_HZ = 1e8;
+constexpr double MAX_TSC_HZ = 1e10;
+
+// CPUID.80000007H:EDX[8], the TSC ticks at a constant rate in all P/C-states
+bool hasInvariantTsc() {
+    unsigned eax, ebx, ecx, edx;
+    if (!__get_cpuid(0x80000000, &eax, &ebx, &ecx, &edx) || eax < 0x80000007) {
+        return false;
+    }
+    __get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx);
+    return (edx & (1u << 8)) != 0;
+}
+
+// Linux switches away from the TSC when it sees it drift or skew between
+// cores, and may keep listing it as available afterwards; only the current
+// clocksource counts. If sysfs is unavailable, trust the CPU flag alone.
+bool kernelTrustsTsc() {
+    std::ifstream file("/sys/devices/system/clocksource/clocksource0/current_clocksource");
+    std::string source;
+    if (!file) {
+        return true;
+    }
+    return file >> source && source == "tsc";
+}
+
+// TSC and steady_clock read as close together as possible: keep the pair
+// whose bracketing TSC reads are nearest
+void samplePair(uint64_t& ticks, int64_t& ns) {
+    uint64_t best = UINT64_MAX;
+    for (int i = 0; i < 8; ++i) {
+        uint64_t before = __rdtsc();
+        int64_t now = std::chrono::steady_clock::now().time_since_epoch().count();
+        uint64_t after = __rdtsc();
+        if (after - before < best) {
+            best = after - before;
+            ticks = before + (after - before) / 2;
+            ns = now;
+        }
+    }
+}
+
+uint64_t nsPerTick(double hz) {
+    return static_cast<uint64_t>(std::llround(1e9 / hz * static_cast<double>(uint64_t{1} << 32)));
+}
+#endif
+
+} // namespace
+
+void TscClock::calibrate(Calibration& cal) {
+#if defined(__x86_64__)
+    static_assert(SHIFT == 32, "nsPerTick() is 32.32 fixed point");
+    if (!hasInvariantTsc() || !kernelTrustsTsc()) {
+        return;
+    }
+
+    uint64_t startTicks = 0, endTicks = 0;
+    int64_t startNs = 0, endNs = 0;
+    samplePair(startTicks, startNs);
+    std::this_thread::sleep_for(CALIBRATION_PERIOD);
+    samplePair(endTicks, endNs);
+    if (endTicks <= startTicks || endNs <= startNs) {
+        return;
+    }
+
+    double hz = static_cast<double>(endTicks - startTicks) * 1e9 / static_cast<double>(endNs - startNs);
+    if (hz < MIN_TSC_HZ || hz > MAX_TSC_HZ) {
+        return;
+    }
+    cal.ticksPerSecond.store(hz, std::memory_order_relaxed);
+    cal.multiplier.store(nsPerTick(hz), std::memory_order_relaxed);
+    cal.baseTicks.store(endTicks, std::memory_order_relaxed);
+    cal.baseNs.store(endNs, std::memory_order_relaxed);
+    cal.originTicks = startTicks;
+    cal.originNs = startNs;
+    cal.periodTicks = static_cast<int64_t>(hz * std::chrono::duration<double>(RECALIBRATION_PERIOD).count());
+    cal.useTsc = true;
+#else
+    (void)cal;
+#endif
+}
+
+// Re-measure the rate over the whole run, which a 20 ms first calibration can
+// only estimate to about a part per million, and pick the multiplier that also
+// closes the gap to steady_clock over the next period. The new base is where
+// the old parameters put the clock, so time stays continuous; an implausible
+// measurement only moves the base and keeps the rate.
+void TscClock::recalibrate(Calibration& cal) noexcept {
+#if defined(__x86_64__)
+    if (cal.recalibrating.exchange(true, std::memory_order_acquire)) {
+        return;
+    }
+    uint64_t ticks = 0;
+    int64_t ns = 0;
+    samplePair(ticks, ns);
+
+    __extension__ typedef __int128 Wide;
+    uint64_t baseTicks = cal.baseTicks.load(std::memory_order_relaxed);
+    auto sinceBase = static_cast<int64_t>(ticks - baseTicks);
+    rep clockNs = cal.baseNs.load(std::memory_order_relaxed) +
+        static_cast<rep>((static_cast<Wide>(sinceBase) *
+                          static_cast<Wide>(cal.multiplier.load(std::memory_order_relaxed))) >> SHIFT);
+
+    uint64_t multiplier = cal.multiplier.load(std::memory_order_relaxed);
+    double hz = static_cast<double>(ticks - cal.originTicks) * 1e9 / static_cast<double>(ns - cal.originNs);
+    bool plausible = ns > cal.originNs && hz >= MIN_TSC_HZ && hz <= MAX_TSC_HZ;
+    if (plausible) {
+        double period = std::chrono::duration<double, std::nano>(RECALIBRATION_PERIOD).count();
+        double slew = std::max(-MAX_SLEW, std::min(MAX_SLEW, static_cast<double>(ns - clockNs) / period));
+        multiplier = nsPerTick(hz / (1.0 + slew));
+    }
+
+    cal.sequence.fetch_add(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    cal.baseTicks.store(ticks, std::memory_order_relaxed);
+    cal.baseNs.store(clockNs, std::memory_order_relaxed);
+    cal.multiplier.store(multiplier, std::memory_order_relaxed);
+    cal.sequence.fetch_add(1, std::memory_order_release);
+    if (plausible) {
+        cal.ticksPerSecond.store(hz, std::memory_order_relaxed);
+    }
+    cal.recalibrating.store(false, std::memory_order_release);
+#else
+    (void)cal;
+#endif
+}
+
+} // namespace dcs
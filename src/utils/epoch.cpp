@@ -0,0 +1,125 @@
+#include <dcs/utils/epoch.h>
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <thread>
+
+namespace dcs {
+
+// Per-thread registration: claims a reader slot on first use and releases it
+// when the thread exits so slots are recycled across short-lived threads.
+struct EpochDomain::ThreadState {
+    EpochDomain* domain{nullptr};
+    ReaderSlot* slot{nullptr};
+    uint32_t depth{0};
+
+    ~ThreadState() {
+        if (slot) {
+            slot->epoch.store(0, std::memory_order_release);
+            slot->claimed.store(false, std::memory_order_release);
+        }
+    }
+};
+
+EpochDomain& EpochDomain::instance() {
+    static EpochDomain domain;
+    return domain;
+}
+
+EpochDomain::ThreadState& EpochDomain::threadState() {
+    thread_local ThreadState state;
+    if (!state.slot) {
+        for (auto& slot : slots_) {
+            bool expected = false;
+            if (!slot.claimed.load(std::memory_order_relaxed) &&
+                slot.claimed.compare_exchange_strong(expected, true, std::memory_order_acq_rel)) {
+                state.domain = this;
+                state.slot = &slot;
+                break;
+            }
+        }
+        if (!state.slot) {
+            throw std::runtime_error("EpochDomain: more than MAX_THREADS concurrent readers");
+        }
+    }
+    return state;
+}
+
+void EpochDomain::enter() {
+    ThreadState& state = threadState();
+    if (state.depth++ == 0) {
+        state.slot->epoch.store(globalEpoch_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        // Order the slot publication before any read of the protected objects
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+    }
+}
+
+void EpochDomain::exit() {
+    ThreadState& state = threadState();
+    if (--state.depth == 0) {
+        state.slot->epoch.store(0, std::memory_order_release);
+    }
+}
+
+bool EpochDomain::inReadSection() {
+    return threadState().depth > 0;
+}
+
+uint64_t EpochDomain::oldestActiveEpoch() const {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    uint64_t oldest = std::numeric_limits<uint64_t>::max();
+    for (const auto& slot : slots_) {
+        uint64_t epoch = slot.epoch.load(std::memory_order_acquire);
+        if (epoch != 0) {
+            oldest = std::min(oldest, epoch);
+        }
+    }
+    return oldest;
+}
+
+void EpochDomain::retire(std::function<void()> deleter) {
+    // Objects are unlinked before retire(), so readers entering after the
+    // bump can no longer reach them; only readers at or before `epoch` can.
+    uint64_t epoch = globalEpoch_.fetch_add(1, std::memory_order_acq_rel);
+    {
+        std::lock_guard<std::mutex> lock(retiredMutex_);
+        retired_.push_back({epoch, std::move(deleter)});
+    }
+    reclaim();
+}
+
+size_t EpochDomain::reclaim() {
+    uint64_t oldest = oldestActiveEpoch();
+
+    std::vector<std::function<void()>> ready;
+    {
+        std::lock_guard<std::mutex> lock(retiredMutex_);
+        auto split = std::partition(retired_.begin(), retired_.end(),
+                                    [oldest](const Retired& r) { return r.epoch >= oldest; });
+        for (auto it = split; it != retired_.end(); ++it) {
+            ready.push_back(std::move(it->deleter));
+        }
+        retired_.erase(split, retired_.end());
+    }
+
+    // Deleters run outside the lock; they may unload libraries or retire more
+    for (auto& deleter : ready) {
+        deleter();
+    }
+    return ready.size();
+}
+
+void EpochDomain::synchronize() {
+    uint64_t target = globalEpoch_.fetch_add(1, std::memory_order_acq_rel);
+    while (oldestActiveEpoch() <= target) {
+        std::this_thread::yield();
+    }
+    reclaim();
+}
+
+size_t EpochDomain::pendingCount() const {
+    std::lock_guard<std::mutex> lock(retiredMutex_);
+    return retired_.size();
+}
+
+} // namespace dcs
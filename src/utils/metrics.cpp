@@ -0,0 +1,162 @@
+#include <dcs/utils/metrics.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <thread>
+#include <unistd.h>
+
+namespace dcs {
+
+void LatencyHistogram::merge(const LatencyHistogram& other) {
+    for (size_t i = 0; i < BUCKET_COUNT; ++i) {
+        uint64_t n = other.counts_[i].load(std::memory_order_relaxed);
+        if (n) {
+            counts_[i].fetch_add(n, std::memory_order_relaxed);
+        }
+    }
+    totalCount_.fetch_add(other.totalCount_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    sum_.fetch_add(other.sum_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    updateMin(other.min_.load(std::memory_order_relaxed));
+    updateMax(other.max_.load(std::memory_order_relaxed));
+}
+
+void LatencyHistogram::reset() {
+    for (auto& bucket : counts_) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+    totalCount_.store(0, std::memory_order_relaxed);
+    sum_.store(0, std::memory_order_relaxed);
+    min_.store(std::numeric_limits<uint64_t>::max(), std::memory_order_relaxed);
+    max_.store(0, std::memory_order_relaxed);
+}
+
+uint64_t LatencyHistogram::percentile(double p) const {
+    // Sum the buckets rather than trusting totalCount_, which a concurrent
+    // recorder may have bumped before its bucket increment became visible
+    uint64_t total = 0;
+    for (const auto& bucket : counts_) {
+        total += bucket.load(std::memory_order_relaxed);
+    }
+    if (total == 0) {
+        return 0;
+    }
+
+    p = std::min(std::max(p, 0.0), 100.0);
+    auto target = static_cast<uint64_t>(std::ceil(p / 100.0 * static_cast<double>(total)));
+    target = std::max<uint64_t>(target, 1);
+
+    uint64_t seen = 0;
+    for (size_t i = 0; i < BUCKET_COUNT; ++i) {
+        seen += counts_[i].load(std::memory_order_relaxed);
+        if (seen >= target) {
+            return std::min(bucketUpperBound(i), max());
+        }
+    }
+    return max();
+}
+
+LatencySummary LatencyHistogram::summary() const {
+    LatencySummary s;
+    s.count = count();
+    if (s.count == 0) {
+        return s;
+    }
+    s.min = min_.load(std::memory_order_relaxed);
+    s.max = max();
+    s.mean = static_cast<double>(sum_.load(std::memory_order_relaxed)) / static_cast<double>(s.count);
+    s.p50 = percentile(50.0);
+    s.p90 = percentile(90.0);
+    s.p99 = percentile(99.0);
+    s.p999 = percentile(99.9);
+    return s;
+}
+
+ShardedLatencyHistogram::ShardedLatencyHistogram() {
+    long cpus = sysconf(_SC_NPROCESSORS_CONF);
+    shardCount_ = cpus > 0 ? static_cast<size_t>(cpus) : 1;
+    shards_.reset(new std::atomic<Shard*>[shardCount_]);
+    for (size_t i = 0; i < shardCount_; ++i) {
+        shards_[i].store(nullptr, std::memory_order_relaxed);
+    }
+}
+
+ShardedLatencyHistogram::~ShardedLatencyHistogram() {
+    for (size_t i = 0; i < shardCount_; ++i) {
+        delete shards_[i].load(std::memory_order_relaxed);
+    }
+}
+
+// First record on a CPU; racing threads agree on one shard
+ShardedLatencyHistogram::Shard& ShardedLatencyHistogram::createShard(size_t index) {
+    auto created = std::make_unique<Shard>();
+    Shard* expected = nullptr;
+    if (shards_[index].compare_exchange_strong(expected, created.get(), std::memory_order_acq_rel)) {
+        return *created.release();
+    }
+    return *expected;
+}
+
+uint64_t ShardedLatencyHistogram::errorCount() const {
+    uint64_t total = 0;
+    for (size_t i = 0; i < shardCount_; ++i) {
+        if (const Shard* shard = shards_[i].load(std::memory_order_acquire)) {
+            total += shard->errors.load(std::memory_order_relaxed);
+        }
+    }
+    return total;
+}
+
+void ShardedLatencyHistogram::snapshot(LatencyHistogram& out) const {
+    // A record is a handful of stores, so spin briefly; past that the
+    // recorder was likely preempted and yielding lets it finish. The budget
+    // keeps a shard that never goes quiet from stalling the reader.
+    constexpr int SPIN_ATTEMPTS = 64;
+    constexpr auto RETRY_BUDGET = std::chrono::milliseconds(1);
+    auto scratch = std::make_unique<LatencyHistogram>();
+
+    for (size_t i = 0; i < shardCount_; ++i) {
+        const Shard* shard = shards_[i].load(std::memory_order_acquire);
+        if (!shard || shard->end.load(std::memory_order_acquire) == 0) {
+            continue;
+        }
+        std::chrono::steady_clock::time_point giveUp{};
+        for (int attempt = 0;; ++attempt) {
+            scratch->reset();
+            uint64_t finished = shard->end.load(std::memory_order_acquire);
+            scratch->merge(shard->histogram);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            uint64_t started = shard->begin.load(std::memory_order_relaxed);
+            if (started == finished) {
+                break;
+            }
+            if (attempt < SPIN_ATTEMPTS) {
+                cpuRelax();
+                continue;
+            }
+            auto now = std::chrono::steady_clock::now();
+            if (attempt == SPIN_ATTEMPTS) {
+                giveUp = now + RETRY_BUDGET;
+            } else if (now >= giveUp) {
+                break;
+            }
+            std::this_thread::yield();
+        }
+        out.merge(*scratch);
+    }
+}
+
+LatencySummary ShardedLatencyHistogram::summary() const {
+    auto merged = std::make_unique<LatencyHistogram>();
+    snapshot(*merged);
+    return merged->summary();
+}
+
+uint64_t ShardedLatencyHistogram::percentile(double p) const {
+    auto merged = std::make_unique<LatencyHistogram>();
+    snapshot(*merged);
+    return merged->percentile(p);
+}
+
+} // namespace dcs
@@ -0,0 +1,92 @@
+#include <dcs/utils/realtime.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <sched.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace dcs {
+
+namespace {
+
+size_t pageSize() {
+    static const size_t size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    return size;
+}
+
+} // namespace
+
+std::string setThreadPriority(pthread_t thread, int priority) {
+    if (priority == 0) {
+        return {};
+    }
+    if (priority < sched_get_priority_min(SCHED_FIFO) || priority > sched_get_priority_max(SCHED_FIFO)) {
+        return "SCHED_FIFO priority " + std::to_string(priority) + " out of range";
+    }
+    sched_param param{};
+    param.sched_priority = priority;
+    int error = pthread_setschedparam(thread, SCHED_FIFO, &param);
+    if (error != 0) {
+        return "SCHED_FIFO priority " + std::to_string(priority) + " not applied: " + std::strerror(error);
+    }
+    return {};
+}
+
+std::string setThreadAffinity(pthread_t thread, const std::vector<int>& cpus) {
+    if (cpus.empty()) {
+        return {};
+    }
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : cpus) {
+        if (cpu >= 0 && cpu < CPU_SETSIZE) {
+            CPU_SET(cpu, &set);
+        }
+    }
+    int error = pthread_setaffinity_np(thread, sizeof(set), &set);
+    if (error != 0) {
+        return std::string("CPU affinity not applied: ") + std::strerror(error);
+    }
+    return {};
+}
+
+std::string lockProcessMemory() {
+    if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0) {
+        return std::string("mlockall failed: ") + std::strerror(errno);
+    }
+    return {};
+}
+
+void prefaultMemory(void* data, size_t bytes) {
+    auto bytesPtr = static_cast<unsigned char*>(data);
+    for (size_t offset = 0; offset < bytes; offset += pageSize()) {
+        // An atomic no-op write: takes the write fault, and is harmless even if
+        // another process is using the page concurrently
+        __atomic_fetch_or(bytesPtr + offset, static_cast<unsigned char>(0), __ATOMIC_RELAXED);
+    }
+}
+
+void prefaultStack(size_t bytes) {
+    auto stack = static_cast<volatile unsigned char*>(__builtin_alloca(bytes));
+    for (size_t offset = 0; offset < bytes; offset += pageSize()) {
+        stack[offset] = 0;
+    }
+}
+
+std::vector<int> cpusExcluding(const std::vector<int>& excluded) {
+    std::vector<int> cpus;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) != 0) {
+        return cpus;
+    }
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+        if (CPU_ISSET(cpu, &set) && std::find(excluded.begin(), excluded.end(), cpu) == excluded.end()) {
+            cpus.push_back(cpu);
+        }
+    }
+    return cpus;
+}
+
+} // namespace dcs
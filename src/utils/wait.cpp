@@ -0,0 +1,47 @@
+#include <dcs/utils/wait.h>
+#include <cerrno>
+#include <time.h>
+
+namespace dcs {
+
+namespace {
+
+constexpr int64_t NS_PER_SEC = 1000000000;
+
+} // namespace
+
+WaitStrategy::WaitStrategy(const WaitOptions& options)
+    : options_(options), wakeLatencyNs_(options.initialSpinNs * 4 / 5) {}
+
+int64_t WaitStrategy::waitUntil(int64_t deadlineNs) {
+    int64_t now = nowNs();
+    if (options_.mode == WaitMode::SLEEP) {
+        if (deadlineNs > now) {
+            sleepUntil(deadlineNs);
+        }
+    } else {
+        int64_t wakeAt = options_.mode == WaitMode::SPIN_THEN_SLEEP ? deadlineNs - spinBudgetNs() : now;
+        if (wakeAt > now) {
+            sleepUntil(wakeAt);
+        }
+        while (nowNs() < deadlineNs) {
+            cpuRelax();
+        }
+    }
+    return nowNs() - deadlineNs;
+}
+
+void WaitStrategy::sleepUntil(int64_t targetNs) {
+    timespec ts;
+    ts.tv_sec = static_cast<time_t>(targetNs / NS_PER_SEC);
+    ts.tv_nsec = static_cast<long>(targetNs % NS_PER_SEC);
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR) {
+    }
+
+    // Track the peak overshoot, letting it decay by 1/32 per sleep so one
+    // bad wake-up does not pin the budget high forever
+    int64_t late = std::max<int64_t>(0, nowNs() - targetNs);
+    wakeLatencyNs_ = std::max(late, wakeLatencyNs_ - wakeLatencyNs_ / 32);
+}
+
+} // namespace dcs